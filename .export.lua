@@ -29,13 +29,32 @@ project "lineal"
     kind "StaticLib"       
 
     files {
-        "lineal/include/**.h"
+        "lineal/include/**.h",
+        "lineal/src/**.cpp"
     } 
+
+    -- The precompiled kernels are optimised here, whatever the optimisation level of the client.
+    optimize "Speed"
+    vectorize "On"
+
+    filter "toolset:gcc or toolset:clang"
+        buildoptions { "-O3", "-funroll-loops" }
+
+    filter {}
     
-    zpm.uses("Zefiros-Software/simdpp")
+    zpm.uses {
+        "Zefiros-Software/MKL",
+        "Zefiros-Software/simdpp"
+    }
 
     zpm.export(function()
         includedirs "lineal/include/"
+        defines "LINEAL_PRECOMPILED"
         zpm.uses("Zefiros-Software/simdpp")
         cppdialect "C++17"
+
+        filter "system:linux"
+            links "pthread"
+
+        filter {}
     end)
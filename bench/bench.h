@@ -0,0 +1,74 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/lineal.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+
+namespace lineal
+{
+    namespace bench
+    {
+        // Sizes from a few registers up to 10^8 elements, well past the last level cache.
+        inline void sizes(benchmark::internal::Benchmark *b)
+        {
+            b->RangeMultiplier(8)->Range(8, 100000000);
+        }
+
+        // Element types whose scalar multiply and divide have SIMD kernels; integer vectors only get additive ops.
+        template<typename tT>
+        constexpr bool has_multiply = std::is_floating_point_v<tT>;
+
+        /**
+         * Runs `func` for every benchmark iteration and reports per-element cost, achieved bandwidth and FLOP rate as
+         * counters, which end up in the JSON output (`--benchmark_format=json`). The loop is timed here instead of
+         * through rate counters, so the values do not depend on the GoogleBenchmark version.
+         */
+        template<typename tFunc>
+        void run(benchmark::State &state, size_t size, double bytes_per_element, double flops_per_element, tFunc &&func)
+        {
+            const auto start = std::chrono::steady_clock::now();
+
+            for (auto _ : state)
+            {
+                func();
+                benchmark::ClobberMemory();
+            }
+
+            const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            const double elements = double(size) * double(state.iterations());
+
+            state.counters["ns/element"] = elapsed / elements;
+            state.counters["GB/s"] = elements * bytes_per_element / elapsed;
+            state.counters["GFLOP/s"] = elements * flops_per_element / elapsed;
+            state.SetItemsProcessed(static_cast<int64_t>(elements));
+        }
+    }
+}
@@ -0,0 +1,197 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "bench.h"
+
+#include <armadillo>
+
+namespace lineal
+{
+    namespace bench
+    {
+        // Scalar ops: one load, one store and one operation per element.
+        template<typename tT>
+        void lineal_scalar_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 1, [&]()
+            {
+                if constexpr(has_multiply<tT>)
+                {
+                    out = a * tT(2);
+                }
+                else
+                {
+                    out = a + tT(2);
+                }
+
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void arma_scalar_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Col<tT> a(size, arma::fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 1, [&]()
+            {
+                if constexpr(has_multiply<tT>)
+                {
+                    out = a * tT(2);
+                }
+                else
+                {
+                    out = a + tT(2);
+                }
+
+                benchmark::DoNotOptimize(out.memptr());
+            });
+        }
+
+        template<typename tT>
+        void lineal_fma(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = a * tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void arma_fma(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Col<tT> a(size, arma::fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = a * tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.memptr());
+            });
+        }
+
+        template<typename tT>
+        void lineal_fda(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = a / tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void arma_fda(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Col<tT> a(size, arma::fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = a / tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.memptr());
+            });
+        }
+
+        // A scalar divided by the vector, which canonicalises into a single rational node.
+        template<typename tT>
+        void lineal_rational(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = tT(3) - tT(2) / a;
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void arma_rational(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Col<tT> a(size, arma::fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                out = tT(3) - tT(2) / a;
+                benchmark::DoNotOptimize(out.memptr());
+            });
+        }
+
+        // Three outputs from one pass over the input.
+        template<typename tT>
+        void lineal_fused(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), r1(size), r2(size);
+            tT s = 0;
+
+            run(state, size, 3 * sizeof(tT), 4, [&]()
+            {
+                fused(assign_to(r1, a * tT(2) + tT(1)), assign_to(r2, a / tT(3)), sum_into(s, a));
+                benchmark::DoNotOptimize(s);
+            });
+        }
+
+        BENCHMARK_TEMPLATE(lineal_scalar_op, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_scalar_op, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_scalar_op, int8_t)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_scalar_op, int32_t)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_scalar_op, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_scalar_op, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_scalar_op, int32_t)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_fma, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_fma, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_fma, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_fma, double)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_fda, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_fda, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_fda, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_fda, double)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_rational, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_rational, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_rational, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_rational, double)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_fused, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_fused, double)->Apply(sizes);
+    }
+}
@@ -0,0 +1,89 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "bench.h"
+
+// Default memory policy against explicit ones on inputs around and past the last level cache. Run with
+// --benchmark_filter=policy; the GB/s counter shows the bandwidth gained by prefetching and streaming stores.
+
+namespace lineal
+{
+    namespace bench
+    {
+        inline void large_sizes(benchmark::internal::Benchmark *b)
+        {
+            b->RangeMultiplier(4)->Range(size_t(1) << 18, size_t(1) << 26);
+        }
+
+        void policy_assign(benchmark::State &state, MemoryPolicy policy)
+        {
+            const size_t size = state.range(0);
+            Col<double> a(size, fill::ones), out(size);
+
+            run(state, size, 2 * sizeof(double), 2, [&]()
+            {
+                out.assign(a * 2.0 + 3.0, policy);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        void policy_sum(benchmark::State &state, MemoryPolicy policy)
+        {
+            const size_t size = state.range(0);
+            Col<double> a(size, fill::ones);
+
+            run(state, size, sizeof(double), 1, [&]()
+            {
+                benchmark::DoNotOptimize(sum(a, policy));
+            });
+        }
+
+        void policy_dot(benchmark::State &state, MemoryPolicy policy)
+        {
+            const size_t size = state.range(0);
+            Row<double> row(size, fill::ones);
+            Col<double> col(size, fill::ones);
+
+            run(state, size, 2 * sizeof(double), 2, [&]()
+            {
+                benchmark::DoNotOptimize(inprod(row, col, policy));
+            });
+        }
+
+        BENCHMARK_CAPTURE(policy_assign, default, memory_policy())->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_assign, cached, MemoryPolicy::cached())->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_assign, streaming, MemoryPolicy::streaming())->Apply(large_sizes);
+
+        BENCHMARK_CAPTURE(policy_sum, default, memory_policy())->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_sum, prefetch_8, MemoryPolicy{ 8 })->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_sum, prefetch_16, MemoryPolicy{ 16 })->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_sum, prefetch_32, MemoryPolicy{ 32 })->Apply(large_sizes);
+
+        BENCHMARK_CAPTURE(policy_dot, default, memory_policy())->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_dot, prefetch_8, MemoryPolicy{ 8 })->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_dot, prefetch_16, MemoryPolicy{ 16 })->Apply(large_sizes);
+        BENCHMARK_CAPTURE(policy_dot, prefetch_32, MemoryPolicy{ 32 })->Apply(large_sizes);
+    }
+}
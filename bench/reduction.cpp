@@ -0,0 +1,159 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "bench.h"
+
+#include <armadillo>
+#include <mkl.h>
+
+namespace lineal
+{
+    namespace bench
+    {
+        template<typename tT>
+        void lineal_sum(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            // Narrow integers would overflow summing up to 1e8 ones, so they sum zeros; only the timing matters.
+            Col<tT> a(size, sizeof(tT) < sizeof(int32_t) ? fill::zeros : fill::ones);
+
+            run(state, size, sizeof(tT), 1, [&]()
+            {
+                benchmark::DoNotOptimize(sum(a));
+            });
+        }
+
+        template<typename tT>
+        void arma_sum(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Col<tT> a(size, arma::fill::ones);
+
+            run(state, size, sizeof(tT), 1, [&]()
+            {
+                benchmark::DoNotOptimize(arma::accu(a));
+            });
+        }
+
+        template<typename tT>
+        void lineal_dot(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Row<tT> row(size, fill::ones);
+            Col<tT> col(size, fill::ones);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                benchmark::DoNotOptimize(tT(row * col));
+            });
+        }
+
+        template<typename tT>
+        void arma_dot(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Row<tT> row(size, arma::fill::ones);
+            arma::Col<tT> col(size, arma::fill::ones);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                benchmark::DoNotOptimize(arma::dot(row, col));
+            });
+        }
+
+        template<typename tT>
+        void cblas_dot(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Row<tT> row(size, fill::ones);
+            Col<tT> col(size, fill::ones);
+
+            run(state, size, 2 * sizeof(tT), 2, [&]()
+            {
+                if constexpr(std::is_same_v<tT, double>)
+                {
+                    benchmark::DoNotOptimize(cblas_ddot(static_cast<int>(size), row.data(), 1, col.data(), 1));
+                }
+                else
+                {
+                    benchmark::DoNotOptimize(cblas_sdot(static_cast<int>(size), row.data(), 1, col.data(), 1));
+                }
+            });
+        }
+
+        // The dot product of two expressions, which used to be the only benchmark in test/main.cpp.
+        template<typename tT>
+        void lineal_dot_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Row<tT> row(size, fill::ones);
+            Col<tT> col(size, fill::ones);
+
+            run(state, size, 2 * sizeof(tT), 5, [&]()
+            {
+                auto row_op = (row * tT(2)) / tT(3);
+                auto col_op = col * tT(2);
+
+                benchmark::DoNotOptimize(tT(row_op * col_op));
+            });
+        }
+
+        template<typename tT>
+        void arma_dot_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            arma::Row<tT> row(size, arma::fill::ones);
+            arma::Col<tT> col(size, arma::fill::ones);
+
+            run(state, size, 2 * sizeof(tT), 5, [&]()
+            {
+                auto row_op = (row * tT(2)) / tT(3);
+                auto col_op = col * tT(2);
+
+                benchmark::DoNotOptimize(arma::as_scalar(row_op * col_op));
+            });
+        }
+
+        BENCHMARK_TEMPLATE(lineal_sum, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_sum, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_sum, int8_t)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_sum, int32_t)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_sum, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_sum, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_sum, int32_t)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_dot, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_dot, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_dot, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_dot, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(cblas_dot, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(cblas_dot, double)->Apply(sizes);
+
+        BENCHMARK_TEMPLATE(lineal_dot_op, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(lineal_dot_op, double)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_dot_op, float)->Apply(sizes);
+        BENCHMARK_TEMPLATE(arma_dot_op, double)->Apply(sizes);
+    }
+}
@@ -0,0 +1,256 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+// Roofline mode, selected with --benchmark_filter=roofline. Every kernel reports its arithmetic intensity from
+// impl::OpCost and how close it gets to the roof set by the measured bandwidth and FLOP peak of this machine.
+
+namespace lineal
+{
+    namespace bench
+    {
+        struct Machine
+        {
+            double bandwidth;
+            double peak;
+        };
+
+        // STREAM triad over arrays far larger than the last level cache, with the same threads lineal uses.
+        inline double measure_bandwidth()
+        {
+            constexpr size_t size = size_t(1) << 24;
+            std::vector<double> a(size, 0.0), b(size, 1.0), c(size, 2.0);
+            double best = 0;
+
+            for (size_t repeat = 0; repeat < 5; ++repeat)
+            {
+                const auto start = std::chrono::steady_clock::now();
+
+                impl::parallel_for(size, impl::chunk_size<double>(), [&](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        a[i] = b[i] + 3.0 * c[i];
+                    }
+                });
+
+                benchmark::DoNotOptimize(a.data());
+                const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                best = std::max(best, 3.0 * sizeof(double) * size / elapsed);
+            }
+
+            return best;
+        }
+
+        /**
+         * Independent multiply-add chains in registers, enough of them to hide the latency of the FMA units. Every chunk
+         * of `parallel_for` runs its own chains, so the peak is measured per element type with the threads lineal uses.
+         */
+        template<typename tT>
+        double measure_peak()
+        {
+            constexpr size_t lanes = 64;
+            constexpr size_t steps = 256;
+            constexpr size_t grain = impl::chunk_size<tT>();
+            const size_t count = std::max(grain * get_num_threads() * 8, get_parallel_threshold() + grain);
+            double best = 0;
+
+            for (size_t repeat = 0; repeat < 5; ++repeat)
+            {
+                std::atomic<size_t> flops(0);
+                const auto start = std::chrono::steady_clock::now();
+
+                impl::parallel_for(count, grain, [&](size_t begin, size_t end)
+                {
+                    const size_t iterations = (end - begin) * steps / lanes;
+
+                    alignas(64) tT x[lanes];
+                    std::fill_n(x, lanes, tT(1));
+
+                    for (size_t k = 0; k < iterations; ++k)
+                    {
+                        for (size_t l = 0; l < lanes; ++l)
+                        {
+                            x[l] = x[l] * tT(0.999999) + tT(1e-6);
+                        }
+                    }
+
+                    benchmark::DoNotOptimize(x);
+                    flops.fetch_add(2 * lanes * iterations, std::memory_order_relaxed);
+                });
+
+                const double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+                best = std::max(best, double(flops.load()) / elapsed);
+            }
+
+            return best;
+        }
+
+        inline double stream_bandwidth()
+        {
+            static const double bandwidth = measure_bandwidth();
+            return bandwidth;
+        }
+
+        template<typename tT>
+        const Machine &machine()
+        {
+            static const Machine baseline{stream_bandwidth(), measure_peak<tT>()};
+            return baseline;
+        }
+
+        template<typename tT, typename tFunc>
+        void run_roofline(benchmark::State &state, size_t size, const impl::Cost &cost, tFunc &&func)
+        {
+            run(state, size, double(cost.bytes), double(cost.flops), func);
+
+            const Machine &baseline = machine<tT>();
+            const double roof = std::min(baseline.peak, cost.intensity() * baseline.bandwidth);
+
+            state.counters["intensity"] = cost.intensity();
+            state.counters["roof GFLOP/s"] = roof;
+            state.counters["roof%"] = roof > 0 ? 100.0 * state.counters["GFLOP/s"].value / roof : 0.0;
+            state.counters["memory_bound"] = cost.intensity() * baseline.bandwidth < baseline.peak ? 1 : 0;
+            state.counters["STREAM GB/s"] = baseline.bandwidth;
+            state.counters["peak GFLOP/s"] = baseline.peak;
+        }
+
+        template<typename tT>
+        void roofline_scalar_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run_roofline<tT>(state, size, impl::assign_cost<tT, decltype(a * tT(2))>, [&]()
+            {
+                out = a * tT(2);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void roofline_fma(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run_roofline<tT>(state, size, impl::assign_cost<tT, decltype(a * tT(2) + tT(3))>, [&]()
+            {
+                out = a * tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void roofline_fda(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run_roofline<tT>(state, size, impl::assign_cost<tT, decltype(a / tT(2) + tT(3))>, [&]()
+            {
+                out = a / tT(2) + tT(3);
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void roofline_rational(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones), out(size);
+
+            run_roofline<tT>(state, size, impl::assign_cost<tT, decltype(tT(3) - tT(2) / a)>, [&]()
+            {
+                out = tT(3) - tT(2) / a;
+                benchmark::DoNotOptimize(out.data());
+            });
+        }
+
+        template<typename tT>
+        void roofline_sum(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Col<tT> a(size, fill::ones);
+
+            run_roofline<tT>(state, size, impl::sum_cost<Col<tT>>, [&]()
+            {
+                benchmark::DoNotOptimize(sum(a));
+            });
+        }
+
+        template<typename tT>
+        void roofline_dot(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Row<tT> row(size, fill::ones);
+            Col<tT> col(size, fill::ones);
+
+            run_roofline<tT>(state, size, impl::op_cost<operations::InProd<Row<tT>, Col<tT>>>, [&]()
+            {
+                benchmark::DoNotOptimize(tT(row * col));
+            });
+        }
+
+        template<typename tT>
+        void roofline_dot_op(benchmark::State &state)
+        {
+            const size_t size = state.range(0);
+            Row<tT> row(size, fill::ones);
+            Col<tT> col(size, fill::ones);
+
+            run_roofline<tT>(state, size, impl::op_cost<operations::InProd<decltype((row * tT(2)) / tT(3)), decltype(col * tT(2))>>, [&]()
+            {
+                benchmark::DoNotOptimize(tT((row * tT(2)) / tT(3) * (col * tT(2))));
+            });
+        }
+
+        // From inside the L1 cache to far beyond the last level cache.
+        inline void roofline_sizes(benchmark::internal::Benchmark *b)
+        {
+            b->RangeMultiplier(64)->Range(1 << 10, 1 << 24);
+        }
+
+        BENCHMARK_TEMPLATE(roofline_scalar_op, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_scalar_op, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_fma, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_fma, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_fda, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_fda, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_rational, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_rational, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_sum, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_sum, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_dot, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_dot, double)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_dot_op, float)->Apply(roofline_sizes);
+        BENCHMARK_TEMPLATE(roofline_dot_op, double)->Apply(roofline_sizes);
+    }
+}
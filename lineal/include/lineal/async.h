@@ -0,0 +1,215 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/parallel.h"
+#include "lineal/types.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+namespace lineal
+{
+    namespace impl
+    {
+        template<typename tT>
+        struct FutureState
+        {
+            using tStorage = std::conditional_t<std::is_void_v<tT>, bool, tT>;
+
+            std::atomic<bool> ready{false};
+            std::mutex mutex;
+            std::condition_variable done;
+            tStorage value{};
+            std::exception_ptr error;
+
+            void finish()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready.store(true, std::memory_order_release);
+                }
+
+                done.notify_all();
+            }
+        };
+    }
+
+    /**
+     * Result of an asynchronous evaluation. The operands of the evaluation are referenced, not copied, so they must
+     * outlive the future.
+     */
+    template<typename tT>
+    class Future
+    {
+    public:
+
+        Future() = default;
+
+        explicit Future(std::shared_ptr<impl::FutureState<tT>> state)
+            : m_state(std::move(state))
+        {
+        }
+
+        bool valid() const
+        {
+            return static_cast<bool>(m_state);
+        }
+
+        bool ready() const
+        {
+            return m_state->ready.load(std::memory_order_acquire);
+        }
+
+        void wait() const
+        {
+            const impl::WorkerIdentity &self = impl::current_worker();
+
+            while (!ready())
+            {
+                // A worker must keep executing tasks, or it could wait on work that sits in its own queue.
+                if (self.pool)
+                {
+                    if (!self.pool->run_one())
+                    {
+                        std::this_thread::yield();
+                    }
+
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_state->mutex);
+                m_state->done.wait(lock, [this]()
+                {
+                    return ready();
+                });
+            }
+        }
+
+        tT get()
+        {
+            wait();
+
+            std::shared_ptr<impl::FutureState<tT>> state = std::move(m_state);
+
+            if (state->error)
+            {
+                std::rethrow_exception(state->error);
+            }
+
+            if constexpr(!std::is_void_v<tT>)
+            {
+                return std::move(state->value);
+            }
+        }
+
+    private:
+
+        std::shared_ptr<impl::FutureState<tT>> m_state;
+    };
+
+    namespace impl
+    {
+        template<typename tVec>
+        struct CaptureRef
+        {
+            const tVec *vec;
+
+            CaptureRef(const tVec &v)
+                : vec(&v)
+            {}
+
+            const tVec &get() const
+            {
+                return *vec;
+            }
+        };
+
+        template<typename tVec>
+        struct CaptureValue
+        {
+            tVec vec;
+
+            CaptureValue(const tVec &v)
+                : vec(v)
+            {}
+
+            const tVec &get() const
+            {
+                return vec;
+            }
+        };
+
+        // Vectors are captured by reference, expression nodes by value since they are usually temporaries.
+        template<typename tVec>
+        using Capture = std::conditional_t<is_raw_vec<tVec>, CaptureRef<tVec>, CaptureValue<tVec>>;
+
+        template<typename tFunc>
+        auto async(tFunc &&func)
+        {
+            using tResult = std::invoke_result_t<tFunc &>;
+
+            auto state = std::make_shared<FutureState<tResult>>();
+
+            auto task = [state, func = std::forward<tFunc>(func)]() mutable
+            {
+                try
+                {
+                    if constexpr(std::is_void_v<tResult>)
+                    {
+                        func();
+                    }
+                    else
+                    {
+                        state->value = func();
+                    }
+                }
+                catch (...)
+                {
+                    state->error = std::current_exception();
+                }
+
+                state->finish();
+            };
+
+            if (std::shared_ptr<ThreadPool> executor = pool())
+            {
+                executor->submit(std::move(task));
+            }
+            else
+            {
+                task();
+            }
+
+            return Future<tResult>(std::move(state));
+        }
+    }
+}
@@ -0,0 +1,179 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/tuning.h"
+#include "lineal/vec.h"
+#include "lineal/vec_vec_op.h"
+
+#include <mkl.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+
+namespace lineal
+{
+    namespace impl
+    {
+        // Best of `repeats` runs of `func`, in nanoseconds; the minimum is the least noisy estimate of a kernel's cost.
+        template<typename tFunc>
+        double best_time(size_t repeats, tFunc &&func)
+        {
+            double best = std::numeric_limits<double>::max();
+            volatile double sink = 0;
+
+            for (size_t r = 0; r < repeats; ++r)
+            {
+                const auto start = std::chrono::steady_clock::now();
+                sink = sink + func();
+                best = std::min(best, std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+            }
+
+            return best;
+        }
+
+        template<typename tT>
+        tT blas_dot(const Row<tT> &row, const Col<tT> &col, size_t size)
+        {
+            if constexpr(std::is_same_v<tT, float>)
+            {
+                return cblas_sdot(static_cast<int>(size), row.data(), 1, col.data(), 1);
+            }
+            else
+            {
+                return cblas_ddot(static_cast<int>(size), row.data(), 1, col.data(), 1);
+            }
+        }
+
+        // Smallest size from which BLAS beats the inline kernel of `config` at every larger size tried.
+        template<typename tT>
+        size_t tune_blas_crossover(const KernelConfig &config)
+        {
+            constexpr size_t largest = size_t(1) << 16;
+
+            Row<tT> row(largest, fill::ones);
+            Col<tT> col(largest, fill::ones);
+            size_t crossover = std::numeric_limits<int>::max();
+
+            for (size_t size = largest; size >= 64; size /= 2)
+            {
+                const double inline_time = best_time(100, [&]
+                {
+                    return inprod_packed_range(row, col, 0, size, config);
+                });
+
+                const double blas_time = best_time(100, [&]
+                {
+                    return blas_dot(row, col, size);
+                });
+
+                if (blas_time >= inline_time)
+                {
+                    break;
+                }
+
+                crossover = size;
+            }
+
+            return crossover;
+        }
+
+        // Time of one inner product and one sum over `size` elements.
+        inline double time_reductions(const Row<double> &row, const Col<double> &col, size_t size, const KernelConfig &config)
+        {
+            return best_time(size < 65536 ? 200 : 10, [&]
+            {
+                return inprod_packed_range(row, col, 0, size, config) + sum_range(col, 0, size, config);
+            });
+        }
+    }
+
+    /**
+     * Micro-benchmarks the reduction and inner product kernel variants on this machine and makes the fastest the
+     * active configuration. Accumulators and unroll are chosen on an L1-resident vector, the prefetch distance on one
+     * far larger than the last level cache, and the BLAS crossovers, per element type, as the smallest size from which
+     * `cblas_ddot` or `cblas_sdot` beats the inline kernel at every larger size tried. When `path` is given the result is saved there, keyed by
+     * `cpu_signature()`, for `load_tuning` or LINEAL_TUNING_FILE to pick up. Takes about a second.
+     */
+    inline KernelConfig autotune(const std::string &path = "")
+    {
+        constexpr size_t small = 2048;
+        constexpr size_t large = size_t(1) << 23;
+
+        Row<double> row(large, fill::ones);
+        Col<double> col(large, fill::ones);
+
+        KernelConfig best = kernel_config();
+        double fastest = std::numeric_limits<double>::max();
+
+        for (const impl::KernelVariant &variant : impl::kernel_variants)
+        {
+            KernelConfig config = best;
+            config.accumulators = variant.accumulators;
+            config.unroll = variant.unroll;
+            config.prefetch_lines = 0;
+
+            const double time = impl::time_reductions(row, col, small, config);
+
+            if (time < fastest)
+            {
+                fastest = time;
+                best.accumulators = variant.accumulators;
+                best.unroll = variant.unroll;
+            }
+        }
+
+        best.prefetch_lines = 0;
+        fastest = impl::time_reductions(row, col, large, best);
+
+        for (size_t lines : { 2, 4, 8, 16, 32 })
+        {
+            KernelConfig config = best;
+            config.prefetch_lines = lines;
+
+            const double time = impl::time_reductions(row, col, large, config);
+
+            if (time < fastest)
+            {
+                fastest = time;
+                best.prefetch_lines = lines;
+            }
+        }
+
+        best.blas_crossover = impl::tune_blas_crossover<double>(best);
+        best.blas_crossover_float = impl::tune_blas_crossover<float>(best);
+
+        set_kernel_config(best);
+
+        if (!path.empty())
+        {
+            save_tuning(path, best);
+        }
+
+        return best;
+    }
+}
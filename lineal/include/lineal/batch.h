@@ -0,0 +1,225 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/parallel.h"
+#include "lineal/simd.h"
+#include "lineal/types.h"
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+
+// Number of (row, col) pairs handed to a single thread at a time.
+#ifndef LINEAL_BATCH_GRAIN
+#define LINEAL_BATCH_GRAIN 1024
+#endif
+
+namespace lineal
+{
+    namespace impl
+    {
+        // Lane j of the result holds the sum of the 128-bit register acc[j].
+        template<typename tT, typename t128>
+        t128 transpose_sums_128(const t128 *acc)
+        {
+            if constexpr(sizeof(tT) == 8)
+            {
+                return ::simdpp::add(::simdpp::unzip2_lo(acc[0], acc[1]), ::simdpp::unzip2_hi(acc[0], acc[1]));
+            }
+            else
+            {
+                const t128 ab = ::simdpp::add(::simdpp::unzip4_lo(acc[0], acc[1]), ::simdpp::unzip4_hi(acc[0], acc[1]));
+                const t128 cd = ::simdpp::add(::simdpp::unzip4_lo(acc[2], acc[3]), ::simdpp::unzip4_hi(acc[2], acc[3]));
+
+                return ::simdpp::add(::simdpp::unzip4_lo(ab, cd), ::simdpp::unzip4_hi(ab, cd));
+            }
+        }
+
+        /**
+         * Transposes the accumulators of a group so lane j of the result holds the sum of acc[j]. Wider registers are
+         * first folded to 128 bits, since the de-interleaving shuffles work within 128-bit lanes.
+         */
+        template<typename tT, typename tPacked, size_t tWidth>
+        tPacked transpose_sums(const std::array<tPacked, tWidth> &acc)
+        {
+            using t128 = std::conditional_t<sizeof(tT) == 8, ::simdpp::float64<2>, ::simdpp::float32<4>>;
+            constexpr size_t lanes = 16 / sizeof(tT);
+
+            if constexpr(tWidth == lanes)
+            {
+                return transpose_sums_128<tT>(acc.data());
+            }
+            else
+            {
+                static_assert(tWidth == 2 * lanes, "registers are at most 256 bits wide");
+
+                std::array<t128, tWidth> halves;
+
+                for (size_t j = 0; j < tWidth; ++j)
+                {
+                    t128 lo, hi;
+                    ::simdpp::split(acc[j], lo, hi);
+                    halves[j] = ::simdpp::add(lo, hi);
+                }
+
+                return ::simdpp::combine(transpose_sums_128<tT>(halves.data()),
+                                         transpose_sums_128<tT>(halves.data() + lanes));
+            }
+        }
+
+        /**
+         * Computes the dot products of one group of at most `PackedTypeHelper<tT>::count` pairs. Every pair has its own
+         * accumulator register and the pairs advance in lockstep, which hides the latency of the multiply-add chain.
+         * Floating point accumulators are then transposed and reduced in registers; other types are summed per lane.
+         */
+        template<typename tT, typename tRow, typename tCol>
+        void inprod_group(const tRow *const *rows, const tCol *const *cols, size_t lanes, tT *results)
+        {
+            using tPackedHelper = PackedTypeHelper<tT>;
+            using tPacked = typename tPackedHelper::type;
+            constexpr size_t width = tPackedHelper::count;
+
+            std::array<tPacked, width> acc;
+            std::array<size_t, width> blocks{};
+
+            const tT zero = 0;
+            size_t common = ~size_t(0);
+
+            for (size_t j = 0; j < width; ++j)
+            {
+                acc[j] = ::simdpp::load_splat(&zero);
+
+                if (j < lanes)
+                {
+                    blocks[j] = rows[j]->size() / width;
+                    common = std::min(common, blocks[j]);
+                }
+            }
+
+            for (size_t k = 0; k < common; ++k)
+            {
+                for (size_t j = 0; j < lanes; ++j)
+                {
+                    tPacked a = ::simdpp::load_u(rows[j]->data() + k * width);
+                    tPacked b = ::simdpp::load_u(cols[j]->data() + k * width);
+                    acc[j] = ::simdpp::add(::simdpp::mul(a, b), acc[j]);
+                }
+            }
+
+            for (size_t j = 0; j < lanes; ++j)
+            {
+                for (size_t k = common; k < blocks[j]; ++k)
+                {
+                    tPacked a = ::simdpp::load_u(rows[j]->data() + k * width);
+                    tPacked b = ::simdpp::load_u(cols[j]->data() + k * width);
+                    acc[j] = ::simdpp::add(::simdpp::mul(a, b), acc[j]);
+                }
+            }
+
+            alignas(sizeof(tPacked)) tT sums[width];
+
+            if constexpr(std::is_floating_point_v<tT>)
+            {
+                ::simdpp::store(sums, tPacked(transpose_sums<tT>(acc)));
+            }
+            else
+            {
+                for (size_t j = 0; j < lanes; ++j)
+                {
+                    sums[j] = ::simdpp::reduce_add(acc[j]);
+                }
+            }
+
+            for (size_t j = 0; j < lanes; ++j)
+            {
+                tT res = sums[j];
+                const tT *row = rows[j]->data();
+                const tT *col = cols[j]->data();
+
+                for (size_t i = blocks[j] * width, end = rows[j]->size(); i < end; ++i)
+                {
+                    res += row[i] * col[i];
+                }
+
+                results[j] = res;
+            }
+        }
+
+        template<typename tT, typename tRow, typename tCol>
+        void inprod_batch_range(const tRow *const *rows, const tCol *const *cols, tT *results, size_t begin, size_t end)
+        {
+            constexpr size_t width = PackedTypeHelper<tT>::count;
+
+            for (size_t i = begin; i < end; i += width)
+            {
+                inprod_group(rows + i, cols + i, std::min(width, end - i), results + i);
+            }
+        }
+    }
+
+    /**
+     * Computes results[i] = *rows[i] * *cols[i] for `count` independent pairs of raw vectors. The lengths may differ
+     * between pairs, but each row must be as long as its column.
+     */
+    template<typename tRow, typename tCol, typename tT = PreciseType<typename tRow::value_type, typename tCol::value_type>>
+    void inprod_batch(const tRow *const *rows, const tCol *const *cols, size_t count, tT *results)
+    {
+        static_assert(is_row<tRow> &&is_col<tCol>, "inprod_batch expects rows and columns");
+        static_assert(is_raw_vec<tRow> &&is_raw_vec<tCol>, "inprod_batch expects raw vectors");
+        static_assert(!is_strided_vec<tRow> && !is_strided_vec<tCol>, "inprod_batch expects contiguous vectors");
+        static_assert(std::is_same_v<typename tRow::value_type, tT> && std::is_same_v<typename tCol::value_type, tT>,
+                      "inprod_batch expects a single element type");
+
+        constexpr size_t width = impl::PackedTypeHelper<tT>::count;
+        constexpr size_t grain = (LINEAL_BATCH_GRAIN + width - 1) / width * width;
+
+        size_t elements = 0;
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            LINEAL_ASSERT(rows[i]->size() == cols[i]->size(), "inprod_batch pairs must have equal lengths");
+            elements += rows[i]->size();
+        }
+
+        LINEAL_COUNT(batch_elements, elements);
+        LINEAL_TRACE(batch, elements);
+
+        std::shared_ptr<impl::ThreadPool> executor = count > grain && elements >= get_parallel_threshold() ? impl::pool() : nullptr;
+
+        if (!executor)
+        {
+            impl::inprod_batch_range(rows, cols, results, 0, count);
+            return;
+        }
+
+        impl::run_chunks(*executor, (count + grain - 1) / grain, [&](size_t chunk)
+        {
+            impl::inprod_batch_range(rows, cols, results, chunk * grain, std::min(count, (chunk + 1) * grain));
+        });
+    }
+}
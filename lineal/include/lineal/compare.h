@@ -0,0 +1,669 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/unary.h"
+#include "lineal/vec_scalar_op.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/types.h"
+
+#include <algorithm>
+#include <type_traits>
+
+namespace lineal
+{
+    // Operands of element-wise min, max and comparisons: a vector and a scalar, or two vectors of the same orientation.
+    template<typename tLhs, typename tRhs>
+    constexpr bool elementwise_type = (is_vec<tLhs> &&is_numeric<tRhs>) || (is_numeric<tLhs> &&is_vec<tRhs>) ||
+                                      (is_vec<tLhs> &&is_vec<tRhs> &&is_row<tLhs> == is_row<tRhs>);
+
+    namespace impl
+    {
+        // The vector of a pair of operands of which at most one is a scalar.
+        template<typename tLhs, typename tRhs>
+        using VecSide = std::conditional_t<is_vec<tLhs>, tLhs, tRhs>;
+
+        // Whether an element-wise operand covers `size` elements; scalars are broadcast to any size.
+        template<typename tX>
+        bool fits_size(const tX &x, size_t size)
+        {
+            if constexpr(is_vec<tX>)
+            {
+                return x.size() == size;
+            }
+            else
+            {
+                return true;
+            }
+        }
+
+        /**
+         * Operand of an element-wise node, either a vector expression or a scalar. Scalars are converted to the element
+         * type of the node and broadcast to every lane; non-integral scalars are rejected against integer elements.
+         */
+        template<typename tX, typename tT, typename = void>
+        struct ElementSource
+        {
+            static_assert(!std::is_integral_v<tT> || std::is_integral_v<tX>,
+                          "a floating point scalar would be truncated to the integer elements; convert it explicitly");
+
+            const tT scalar;
+
+            ElementSource(const tX &x)
+                : scalar(static_cast<tT>(x))
+            {}
+
+            tT operator[](size_t) const
+            {
+                return scalar;
+            }
+
+            template<typename tPacked>
+            void load(size_t, tPacked &v) const
+            {
+                v = ::simdpp::load_splat(&scalar);
+            }
+        };
+
+        template<typename tX, typename tT>
+        struct ElementSource<tX, tT, std::enable_if_t<is_vec<tX>>>
+        {
+            static_assert(std::is_same_v<typename tX::value_type, tT>, "element-wise operands need the same element type");
+
+            std::conditional_t<is_raw_vec<tX>, const tX &, const tX> vec;
+
+            ElementSource(const tX &x)
+                : vec(x)
+            {}
+
+            tT operator[](size_t i) const
+            {
+                return vec[i];
+            }
+
+            template<typename tPacked>
+            void load(size_t i, tPacked &v) const
+            {
+                SIMDAccess::load_operand(vec, i, v);
+            }
+        };
+
+        // Scalar min and max follow the SSE and AVX instructions: when either operand is NaN the second one is returned.
+        struct MinFunc
+        {
+            static constexpr Cost cost = {0, 0, 1, 0, 0};
+
+            template<typename tT>
+            static tT apply(tT a, tT b)
+            {
+                return a < b ? a : b;
+            }
+
+            template<typename tPacked>
+            static tPacked packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::min(a, b);
+            }
+        };
+
+        struct MaxFunc
+        {
+            static constexpr Cost cost = {0, 0, 1, 0, 0};
+
+            template<typename tT>
+            static tT apply(tT a, tT b)
+            {
+                return a > b ? a : b;
+            }
+
+            template<typename tPacked>
+            static tPacked packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::max(a, b);
+            }
+        };
+
+        struct LessFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a < b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_lt(a, b);
+            }
+        };
+
+        struct LessEqualFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a <= b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_le(a, b);
+            }
+        };
+
+        struct GreaterFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a > b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_gt(a, b);
+            }
+        };
+
+        struct GreaterEqualFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a >= b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_ge(a, b);
+            }
+        };
+
+        struct EqualFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a == b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_eq(a, b);
+            }
+        };
+
+        struct NotEqualFunc
+        {
+            template<typename tT>
+            static bool apply(tT a, tT b)
+            {
+                return a != b;
+            }
+
+            template<typename tPacked>
+            static typename tPacked::mask_vector_type packed(const tPacked &a, const tPacked &b)
+            {
+                return ::simdpp::cmp_neq(a, b);
+            }
+        };
+
+        struct AndFunc
+        {
+            static bool apply(bool a, bool b)
+            {
+                return a && b;
+            }
+
+            template<typename tMask>
+            static tMask packed(const tMask &a, const tMask &b)
+            {
+                return ::simdpp::bit_and(a, b);
+            }
+        };
+
+        struct OrFunc
+        {
+            static bool apply(bool a, bool b)
+            {
+                return a || b;
+            }
+
+            template<typename tMask>
+            static tMask packed(const tMask &a, const tMask &b)
+            {
+                return ::simdpp::bit_or(a, b);
+            }
+        };
+    }
+
+    namespace operations
+    {
+        // Element-wise binary function of two vectors, or of a vector and a scalar.
+        template<typename tLhs, typename tRhs, typename tFunc>
+        struct VecBinary
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            using value_type = typename impl::VecSide<tLhs, tRhs>::value_type;
+
+            static constexpr impl::Cost own_cost = tFunc::cost;
+
+            const impl::ElementSource<tLhs, value_type> lhs;
+            const impl::ElementSource<tRhs, value_type> rhs;
+
+            VecBinary(const tLhs &l, const tRhs &r)
+                : lhs(l),
+                  rhs(r)
+            {
+                LINEAL_ASSERT(impl::fits_size(l, size()) && impl::fits_size(r, size()), "element-wise operands differ in size");
+            }
+
+            value_type operator[](size_t i) const
+            {
+                return tFunc::apply(lhs[i], rhs[i]);
+            }
+
+            size_t size() const
+            {
+                if constexpr(is_vec<tLhs>)
+                {
+                    return lhs.vec.size();
+                }
+                else
+                {
+                    return rhs.vec.size();
+                }
+            }
+
+        private:
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &, tPacked &) const
+            {}
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &, tPacked &) const
+            {
+                tPacked r;
+                lhs.load(i, v);
+                rhs.load(i, r);
+                v = tFunc::packed(v, r);
+            }
+        };
+
+        /**
+         * Element-wise comparison. A mask is not a vector: `operator[]` gives a bool and the packed form is a simdpp
+         * mask over the compared elements, which only VecSelect and the mask operators consume.
+         */
+        template<typename tLhs, typename tRhs, typename tCmp>
+        struct VecCompare
+        {
+            friend struct impl::SIMDAccess;
+
+            using element_type = typename impl::VecSide<tLhs, tRhs>::value_type;
+            using value_type = bool;
+
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
+            const impl::ElementSource<tLhs, element_type> lhs;
+            const impl::ElementSource<tRhs, element_type> rhs;
+
+            VecCompare(const tLhs &l, const tRhs &r)
+                : lhs(l),
+                  rhs(r)
+            {
+                LINEAL_ASSERT(impl::fits_size(l, size()) && impl::fits_size(r, size()), "compared operands differ in size");
+            }
+
+            bool operator[](size_t i) const
+            {
+                return tCmp::apply(lhs[i], rhs[i]);
+            }
+
+            size_t size() const
+            {
+                if constexpr(is_vec<tLhs>)
+                {
+                    return lhs.vec.size();
+                }
+                else
+                {
+                    return rhs.vec.size();
+                }
+            }
+
+        private:
+
+            template<typename tPacked>
+            typename tPacked::mask_vector_type load_mask(size_t i) const
+            {
+                tPacked a, b;
+                lhs.load(i, a);
+                rhs.load(i, b);
+                return tCmp::packed(a, b);
+            }
+        };
+
+        // `&` and `|` of two masks over the same element type.
+        template<typename tMask0, typename tMask1, typename tLogic>
+        struct MaskLogic
+        {
+            friend struct impl::SIMDAccess;
+
+            using element_type = typename tMask0::element_type;
+            using value_type = bool;
+
+            static_assert(std::is_same_v<element_type, typename tMask1::element_type>, "masks over different element types");
+
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
+            const tMask0 mask0;
+            const tMask1 mask1;
+
+            MaskLogic(const tMask0 &m0, const tMask1 &m1)
+                : mask0(m0),
+                  mask1(m1)
+            {
+                LINEAL_ASSERT(m0.size() == m1.size(), "combined masks differ in size");
+            }
+
+            bool operator[](size_t i) const
+            {
+                return tLogic::apply(mask0[i], mask1[i]);
+            }
+
+            size_t size() const
+            {
+                return mask0.size();
+            }
+
+        private:
+
+            template<typename tPacked>
+            typename tPacked::mask_vector_type load_mask(size_t i) const
+            {
+                return tLogic::packed(impl::SIMDAccess::load_mask<tPacked>(mask0, i), impl::SIMDAccess::load_mask<tPacked>(mask1, i));
+            }
+        };
+
+        template<typename tMask>
+        struct MaskNot
+        {
+            friend struct impl::SIMDAccess;
+
+            using element_type = typename tMask::element_type;
+            using value_type = bool;
+
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
+            const tMask mask;
+
+            MaskNot(const tMask &m)
+                : mask(m)
+            {}
+
+            bool operator[](size_t i) const
+            {
+                return !mask[i];
+            }
+
+            size_t size() const
+            {
+                return mask.size();
+            }
+
+        private:
+
+            template<typename tPacked>
+            typename tPacked::mask_vector_type load_mask(size_t i) const
+            {
+                return ::simdpp::bit_not(impl::SIMDAccess::load_mask<tPacked>(mask, i));
+            }
+        };
+
+        /**
+         * Picks `on` where the mask is set and `off` elsewhere, either of which may be a scalar; the packed form is a
+         * single blend. Both sides are evaluated for every element, so `where(v > 0.0, log(v), 0.0)` computes the
+         * logarithm of the discarded elements as well.
+         */
+        template<typename tMask, typename tOn, typename tOff>
+        struct VecSelect
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            using value_type = typename impl::VecSide<tOn, tOff>::value_type;
+
+            static_assert(std::is_same_v<typename tMask::element_type, value_type>,
+                          "the mask must compare elements of the selected type");
+
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
+            const tMask mask;
+            const impl::ElementSource<tOn, value_type> on;
+            const impl::ElementSource<tOff, value_type> off;
+
+            VecSelect(const tMask &m, const tOn &a, const tOff &b)
+                : mask(m),
+                  on(a),
+                  off(b)
+            {
+                LINEAL_ASSERT(impl::fits_size(a, m.size()) && impl::fits_size(b, m.size()), "selected operands and mask differ in size");
+            }
+
+            value_type operator[](size_t i) const
+            {
+                return mask[i] ? on[i] : off[i];
+            }
+
+            size_t size() const
+            {
+                return mask.size();
+            }
+
+        private:
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &, tPacked &) const
+            {}
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &, tPacked &) const
+            {
+                tPacked b;
+                on.load(i, v);
+                off.load(i, b);
+                v = ::simdpp::blend(v, b, impl::SIMDAccess::load_mask<tPacked>(mask, i));
+            }
+        };
+    }
+
+    template<typename>
+    constexpr bool is_mask = false;
+    template<typename tLhs, typename tRhs, typename tCmp>
+    constexpr bool is_mask<operations::VecCompare<tLhs, tRhs, tCmp>> = true;
+    template<typename tMask0, typename tMask1, typename tLogic>
+    constexpr bool is_mask<operations::MaskLogic<tMask0, tMask1, tLogic>> = true;
+    template<typename tMask>
+    constexpr bool is_mask<operations::MaskNot<tMask>> = true;
+
+    template<typename tLhs, typename tRhs, typename tFunc>
+    constexpr bool is_elementwise_op<operations::VecBinary<tLhs, tRhs, tFunc>> = true;
+    template<typename tMask, typename tOn, typename tOff>
+    constexpr bool is_elementwise_op<operations::VecSelect<tMask, tOn, tOff>> = true;
+
+    template<Orientation tOrient, typename tLhs, typename tRhs, typename tFunc>
+    struct VecOrientationHelper<tOrient, operations::VecBinary<tLhs, tRhs, tFunc>>
+    {
+        constexpr static bool check()
+        {
+            return VecOrientationHelper<tOrient, impl::VecSide<tLhs, tRhs>>::check();
+        }
+    };
+
+    template<Orientation tOrient, typename tMask, typename tOn, typename tOff>
+    struct VecOrientationHelper<tOrient, operations::VecSelect<tMask, tOn, tOff>>
+    {
+        constexpr static bool check()
+        {
+            return VecOrientationHelper<tOrient, impl::VecSide<tOn, tOff>>::check();
+        }
+    };
+
+    namespace impl
+    {
+        template<typename tLhs, typename tRhs, typename tFunc>
+        struct FixedSizeOf<operations::VecBinary<tLhs, tRhs, tFunc>>
+        {
+            static constexpr size_t value = std::max(fixed_size_of<tLhs>, fixed_size_of<tRhs>);
+        };
+
+        template<typename tMask, typename tOn, typename tOff>
+        struct FixedSizeOf<operations::VecSelect<tMask, tOn, tOff>>
+        {
+            static constexpr size_t value = std::max(fixed_size_of<tOn>, fixed_size_of<tOff>);
+        };
+
+        template<typename tLhs, typename tRhs, typename tFunc>
+        struct ComputeBound<operations::VecBinary<tLhs, tRhs, tFunc>>
+            : std::bool_constant<(ComputeBound<tLhs>::value || ComputeBound<tRhs>::value)>
+        {};
+
+        template<typename tLhs, typename tRhs, typename tCmp>
+        struct ComputeBound<operations::VecCompare<tLhs, tRhs, tCmp>>
+            : std::bool_constant<(ComputeBound<tLhs>::value || ComputeBound<tRhs>::value)>
+        {};
+
+        template<typename tMask, typename tOn, typename tOff>
+        struct ComputeBound<operations::VecSelect<tMask, tOn, tOff>>
+            : std::bool_constant<(ComputeBound<tMask>::value || ComputeBound<tOn>::value || ComputeBound<tOff>::value)>
+        {};
+    }
+
+    template<typename tLhs, typename tRhs, std::enable_if_t<elementwise_type<tLhs, tRhs>, int> = 0>
+    auto min(const tLhs &a, const tRhs &b)
+    {
+        return operations::VecBinary<tLhs, tRhs, impl::MinFunc>(a, b);
+    }
+
+    template<typename tLhs, typename tRhs, std::enable_if_t<elementwise_type<tLhs, tRhs>, int> = 0>
+    auto max(const tLhs &a, const tRhs &b)
+    {
+        return operations::VecBinary<tLhs, tRhs, impl::MaxFunc>(a, b);
+    }
+
+    // Limits every element to [lo, hi]; the bounds are scalars or vectors. NaN elements become `lo`.
+    template < typename tVec, typename tLo, typename tHi, std::enable_if_t < is_vec<tVec> &&elementwise_type<tVec, tLo> &&
+               elementwise_type<tVec, tHi>, int > = 0 >
+    auto clamp(const tVec &v, const tLo &lo, const tHi &hi)
+    {
+        return min(max(v, lo), hi);
+    }
+
+    // `on` where the mask is set, `off` elsewhere. Either side may be a scalar, but not both.
+    template < typename tMask, typename tOn, typename tOff, std::enable_if_t < is_mask<tMask> &&(is_vec<tOn> || is_vec<tOff>) &&
+               (is_vec<tOn> || is_numeric<tOn>) && (is_vec<tOff> || is_numeric<tOff>), int > = 0 >
+    auto where(const tMask &mask, const tOn &on, const tOff &off)
+    {
+        return operations::VecSelect<tMask, tOn, tOff>(mask, on, off);
+    }
+
+    // The elements of `v` where the mask is set and zero elsewhere, so `sum(where(v > 0.0, v))` is a masked reduction.
+    template<typename tMask, typename tVec, std::enable_if_t<is_mask<tMask> &&is_vec<tVec>, int> = 0>
+    auto where(const tMask &mask, const tVec &v)
+    {
+        return where(mask, v, typename tVec::value_type(0));
+    }
+
+    template < typename tMask, typename tOn, typename tOff, std::enable_if_t < is_mask<tMask> &&(is_vec<tOn> || is_vec<tOff>) &&
+               (is_vec<tOn> || is_numeric<tOn>) && (is_vec<tOff> || is_numeric<tOff>), int > = 0 >
+    auto select(const tMask &mask, const tOn &on, const tOff &off)
+    {
+        return where(mask, on, off);
+    }
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator<(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::LessFunc>(a, b);
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator<=(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::LessEqualFunc>(a, b);
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator>(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::GreaterFunc>(a, b);
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator>=(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::GreaterEqualFunc>(a, b);
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator==(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::EqualFunc>(a, b);
+}
+
+template<typename tLhs, typename tRhs, typename std::enable_if_t<::lineal::elementwise_type<tLhs, tRhs>, int> = 0>
+auto operator!=(const tLhs &a, const tRhs &b)
+{
+    return ::lineal::operations::VecCompare<tLhs, tRhs, ::lineal::impl::NotEqualFunc>(a, b);
+}
+
+template < typename tMask0, typename tMask1, typename std::enable_if_t < ::lineal::is_mask<tMask0> &&::lineal::is_mask<tMask1>, int > = 0 >
+auto operator&(const tMask0 &a, const tMask1 &b)
+{
+    return ::lineal::operations::MaskLogic<tMask0, tMask1, ::lineal::impl::AndFunc>(a, b);
+}
+
+template < typename tMask0, typename tMask1, typename std::enable_if_t < ::lineal::is_mask<tMask0> &&::lineal::is_mask<tMask1>, int > = 0 >
+auto operator|(const tMask0 &a, const tMask1 &b)
+{
+    return ::lineal::operations::MaskLogic<tMask0, tMask1, ::lineal::impl::OrFunc>(a, b);
+}
+
+template<typename tMask, typename std::enable_if_t<::lineal::is_mask<tMask>, int> = 0>
+auto operator!(const tMask &mask)
+{
+    return ::lineal::operations::MaskNot<tMask>(mask);
+}
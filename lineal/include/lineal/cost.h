@@ -0,0 +1,133 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/vec_scalar_op.h"
+#include "lineal/vec_vec_op.h"
+#include "lineal/transpose.h"
+#include "lineal/unary.h"
+#include "lineal/compare.h"
+#include "lineal/types.h"
+
+#include <type_traits>
+
+namespace lineal
+{
+    namespace impl
+    {
+        /**
+         * Compile-time per-element cost of an expression. Leaves load one element each; every node adds its
+         * `own_cost` to that of its operand. For example `1.0 - 2.0 / v` is one load, two FLOPs and one division.
+         */
+        template<typename tOp, typename = void>
+        struct OpCost
+        {
+            static constexpr Cost value = {1, 0, 0, 0, sizeof(typename tOp::value_type)};
+        };
+
+        template<typename tOp>
+        struct OpCost<tOp, std::void_t<decltype(tOp::own_cost)>>
+        {
+            static constexpr Cost value = tOp::own_cost + OpCost<typename tOp::tOperand>::value;
+        };
+
+        template<typename tOp>
+        struct OpCost<operations::Transpose<tOp>>
+        {
+            static constexpr Cost value = OpCost<tOp>::value;
+        };
+
+        template<typename tOp, typename tFunc>
+        struct OpCost<operations::VecUnary<tOp, tFunc>>
+        {
+            static constexpr Cost value = tFunc::cost + OpCost<tOp>::value;
+        };
+
+        // Scalar operands of element-wise nodes are broadcast once and cost nothing per element.
+        template<typename tX>
+        constexpr Cost operand_cost()
+        {
+            if constexpr(is_vec<tX> || is_mask<tX>)
+            {
+                return OpCost<tX>::value;
+            }
+            else
+            {
+                return Cost{0, 0, 0, 0, 0};
+            }
+        }
+
+        template<typename tLhs, typename tRhs, typename tFunc>
+        struct OpCost<operations::VecBinary<tLhs, tRhs, tFunc>>
+        {
+            static constexpr Cost value = tFunc::cost + operand_cost<tLhs>() + operand_cost<tRhs>();
+        };
+
+        template<typename tLhs, typename tRhs, typename tCmp>
+        struct OpCost<operations::VecCompare<tLhs, tRhs, tCmp>>
+        {
+            static constexpr Cost value = operations::VecCompare<tLhs, tRhs, tCmp>::own_cost + operand_cost<tLhs>() +
+                                          operand_cost<tRhs>();
+        };
+
+        template<typename tMask0, typename tMask1, typename tLogic>
+        struct OpCost<operations::MaskLogic<tMask0, tMask1, tLogic>>
+        {
+            static constexpr Cost value = operations::MaskLogic<tMask0, tMask1, tLogic>::own_cost + OpCost<tMask0>::value +
+                                          OpCost<tMask1>::value;
+        };
+
+        template<typename tMask>
+        struct OpCost<operations::MaskNot<tMask>>
+        {
+            static constexpr Cost value = operations::MaskNot<tMask>::own_cost + OpCost<tMask>::value;
+        };
+
+        template<typename tMask, typename tOn, typename tOff>
+        struct OpCost<operations::VecSelect<tMask, tOn, tOff>>
+        {
+            static constexpr Cost value = operations::VecSelect<tMask, tOn, tOff>::own_cost + OpCost<tMask>::value +
+                                          operand_cost<tOn>() + operand_cost<tOff>();
+        };
+
+        // A multiply and an add per element on top of both operands.
+        template<typename tRow, typename tCol>
+        struct OpCost<operations::InProd<tRow, tCol>>
+        {
+            static constexpr Cost value = OpCost<tRow>::value + OpCost<tCol>::value + Cost{0, 0, 2, 0, 0};
+        };
+
+        template<typename tOp>
+        constexpr Cost op_cost = OpCost<tOp>::value;
+
+        // Cost of evaluating `tOp` into a vector of `tT`.
+        template<typename tT, typename tOp>
+        constexpr Cost assign_cost = op_cost<tOp> + Cost{0, 1, 0, 0, sizeof(tT)};
+
+        // Cost of summing `tVec`.
+        template<typename tVec>
+        constexpr Cost sum_cost = op_cost<tVec> + Cost{0, 0, 1, 0, 0};
+    }
+}
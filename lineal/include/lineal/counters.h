@@ -0,0 +1,201 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// With LINEAL_ENABLE_COUNTERS defined, LINEAL_COUNT bumps a per-thread counter; otherwise it compiles to nothing.
+#if defined(LINEAL_ENABLE_COUNTERS)
+#define LINEAL_COUNT(counter, amount) ::lineal::impl::count(::lineal::Counter::counter, (amount))
+#else
+#define LINEAL_COUNT(counter, amount) ((void)0)
+#endif
+
+namespace lineal
+{
+    enum class Counter
+    {
+        allocations,
+        allocated_bytes,
+        frees,
+        resource_allocations,
+        temporaries,
+        blas_calls,
+        inline_calls,
+        assign_elements,
+        sum_elements,
+        inprod_elements,
+        fused_elements,
+        batch_elements,
+        count
+    };
+
+    constexpr size_t counter_count = static_cast<size_t>(Counter::count);
+
+    inline const char *counter_name(Counter counter)
+    {
+        constexpr const char *names[counter_count] =
+        {
+            "allocations",
+            "allocated_bytes",
+            "frees",
+            "resource_allocations",
+            "temporaries",
+            "blas_calls",
+            "inline_calls",
+            "assign_elements",
+            "sum_elements",
+            "inprod_elements",
+            "fused_elements",
+            "batch_elements"
+        };
+
+        return names[static_cast<size_t>(counter)];
+    }
+
+    struct CounterSnapshot
+    {
+        std::array<uint64_t, counter_count> values{};
+
+        uint64_t operator[](Counter counter) const
+        {
+            return values[static_cast<size_t>(counter)];
+        }
+    };
+
+    namespace impl
+    {
+        /**
+         * Counters of one thread. Only the owning thread writes them, with relaxed loads and stores, so a bump is a
+         * plain add; other threads only read them when taking a snapshot.
+         */
+        struct ThreadCounters
+        {
+            std::array<std::atomic<uint64_t>, counter_count> values{};
+
+            ThreadCounters();
+            ~ThreadCounters();
+
+            void add(Counter counter, uint64_t amount)
+            {
+                std::atomic<uint64_t> &value = values[static_cast<size_t>(counter)];
+                value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+
+            void read_into(CounterSnapshot &snapshot) const
+            {
+                for (size_t i = 0; i < counter_count; ++i)
+                {
+                    snapshot.values[i] += values[i].load(std::memory_order_relaxed);
+                }
+            }
+        };
+
+        // Live threads, plus the totals of threads that have exited and the totals at the last reset.
+        struct CounterRegistry
+        {
+            std::mutex mutex;
+            std::vector<ThreadCounters *> threads;
+            CounterSnapshot retired;
+            CounterSnapshot offset;
+        };
+
+        // Leaked on purpose: thread_local counters of detached workers can retire after static destructors have run.
+        inline CounterRegistry &counter_registry()
+        {
+            static CounterRegistry *registry = new CounterRegistry();
+            return *registry;
+        }
+
+        inline ThreadCounters::ThreadCounters()
+        {
+            CounterRegistry &registry = counter_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(this);
+        }
+
+        inline ThreadCounters::~ThreadCounters()
+        {
+            CounterRegistry &registry = counter_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            read_into(registry.retired);
+            registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+        }
+
+        inline ThreadCounters &thread_counters()
+        {
+            thread_local ThreadCounters counters;
+            return counters;
+        }
+
+        inline void count(Counter counter, uint64_t amount)
+        {
+            thread_counters().add(counter, amount);
+        }
+
+        inline CounterSnapshot total_counters(CounterRegistry &registry)
+        {
+            CounterSnapshot total = registry.retired;
+
+            for (const ThreadCounters *counters : registry.threads)
+            {
+                counters->read_into(total);
+            }
+
+            return total;
+        }
+    }
+
+    // Totals over all threads since the last reset. Always zero unless LINEAL_ENABLE_COUNTERS is defined.
+    inline CounterSnapshot counters()
+    {
+        impl::CounterRegistry &registry = impl::counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        CounterSnapshot snapshot = impl::total_counters(registry);
+
+        for (size_t i = 0; i < counter_count; ++i)
+        {
+            snapshot.values[i] -= registry.offset.values[i];
+        }
+
+        return snapshot;
+    }
+
+    // Restarts counting from zero without touching the counters of running threads.
+    inline void reset_counters()
+    {
+        impl::CounterRegistry &registry = impl::counter_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        registry.offset = impl::total_counters(registry);
+    }
+}
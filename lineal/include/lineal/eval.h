@@ -0,0 +1,167 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/vec_scalar_op.h"
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/parallel.h"
+#include "lineal/simd.h"
+#include "lineal/tuning.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+#include <emmintrin.h>
+#endif
+
+namespace lineal
+{
+    namespace impl
+    {
+        constexpr size_t cache_line_bytes = 64;
+        constexpr size_t page_bytes = 4096;
+
+        inline void store_fence()
+        {
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_IX86)
+            _mm_sfence();
+#else
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+#endif
+        }
+
+        enum class StoreMode
+        {
+            aligned,
+            unaligned,
+            stream
+        };
+
+        template<StoreMode tMode, typename tT, typename tOp>
+        void assign_range(tT *out, const tOp &op, size_t begin, size_t end, size_t prefetch_lines = 0)
+        {
+            using tPackedHelper = PackedTypeHelper<tT>;
+
+            WrapSIMD<tOp> wrapped(op);
+            const auto *source = source_of(op);
+            const size_t ahead = source ? prefetch_lines * cache_line_bytes : 0;
+
+            // Registers narrower than a cache line share one prefetch per line.
+            constexpr size_t per_line = std::max<size_t>(1, cache_line_bytes / (tPackedHelper::count * sizeof(tT)));
+
+            const size_t first = std::min(end, (begin + tPackedHelper::count - 1) / tPackedHelper::count * tPackedHelper::count);
+            const size_t last = std::max(first, end / tPackedHelper::count * tPackedHelper::count);
+
+            for (size_t i = begin; i < first; ++i)
+            {
+                out[i] = op[i];
+            }
+
+            for (size_t i = first / tPackedHelper::count, iEnd = last / tPackedHelper::count; i < iEnd; ++i)
+            {
+                if (ahead != 0 && i % per_line == 0)
+                {
+                    prefetch_ahead<tPackedHelper::count>(source, i * tPackedHelper::count, ahead);
+                }
+
+                if constexpr(tMode == StoreMode::stream)
+                {
+                    simdpp::stream(out + i * tPackedHelper::count, wrapped.load_packed(i));
+                }
+                else if constexpr(tMode == StoreMode::aligned)
+                {
+                    simdpp::store(out + i * tPackedHelper::count, wrapped.load_packed(i));
+                }
+                else
+                {
+                    simdpp::store_u(out + i * tPackedHelper::count, wrapped.load_packed(i));
+                }
+            }
+
+            for (size_t i = last; i < end; ++i)
+            {
+                out[i] = op[i];
+            }
+        }
+
+        /**
+         * Evaluates `op` into `out` under `policy`. Large outputs are split into chunks whose boundaries fall on page
+         * boundaries of the output, so no two threads ever write to the same cache line or split a register.
+         */
+        template<typename tT, typename tOp>
+        void assign(tT *out, const tOp &op, size_t count, const MemoryPolicy &policy = memory_policy())
+        {
+            constexpr size_t grain = chunk_size<tT>();
+            static_assert(grain % (page_bytes / sizeof(tT)) == 0, "chunks must span whole pages");
+
+            LINEAL_COUNT(assign_elements, count);
+            LINEAL_TRACE(assign, count);
+
+            // Views that start inside a register cannot be streamed to.
+            const bool aligned = is_register_aligned(out);
+            const bool stream = aligned && count * sizeof(tT) > policy.streaming_threshold;
+            std::shared_ptr<ThreadPool> executor = use_parallel(count, grain) ? pool() : nullptr;
+
+            auto run = [&](size_t begin, size_t end)
+            {
+                if (stream)
+                {
+                    assign_range<StoreMode::stream>(out, op, begin, end, policy.prefetch_lines);
+                    store_fence();
+                }
+                else if (aligned)
+                {
+                    assign_range<StoreMode::aligned>(out, op, begin, end, policy.prefetch_lines);
+                }
+                else
+                {
+                    assign_range<StoreMode::unaligned>(out, op, begin, end, policy.prefetch_lines);
+                }
+            };
+
+            if (!executor)
+            {
+                run(0, count);
+                return;
+            }
+
+            // Elements before the first page boundary go to the first chunk.
+            const size_t misalignment = reinterpret_cast<std::uintptr_t>(out) % page_bytes;
+            const size_t head = ((page_bytes - misalignment) % page_bytes) / sizeof(tT);
+            const size_t chunks = 1 + (count > head ? (count - head - 1) / grain : 0);
+
+            run_chunks(*executor, chunks, [&](size_t chunk)
+            {
+                const size_t begin = chunk == 0 ? 0 : std::min(count, head + chunk * grain);
+                const size_t end = std::min(count, head + (chunk + 1) * grain);
+
+                run(begin, end);
+            });
+        }
+    }
+}
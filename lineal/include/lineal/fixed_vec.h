@@ -0,0 +1,437 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/vec_scalar_op.h"
+#include "lineal/simd.h"
+#include "lineal/types.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace lineal
+{
+    template<typename, size_t>
+    class ConstFixedRow;
+    template<typename, size_t>
+    class ConstFixedCol;
+
+    namespace impl
+    {
+        template<typename tT, size_t tN>
+        constexpr size_t padded_count = (tN + PackedTypeHelper<tT>::count - 1) / PackedTypeHelper<tT>::count * PackedTypeHelper<tT>::count;
+
+        template<typename tT, typename tOp, size_t... tI, size_t... tJ>
+        void fixed_assign(tT *out, const tOp &op, std::index_sequence<tI...>, std::index_sequence<tJ...>)
+        {
+            constexpr size_t count = PackedTypeHelper<tT>::count;
+            constexpr size_t offset = sizeof...(tI) * count;
+
+            WrapSIMD<tOp> wrapped(op);
+
+            (::simdpp::store(out + tI * count, wrapped.load_packed(tI)), ...);
+            ((out[offset + tJ] = op[offset + tJ]), ...);
+        }
+    }
+
+    /**
+     * Vector with a compile-time size and inline storage. The storage is rounded up to whole registers and the padding
+     * is kept zero, so dot products and sums over owning fixed vectors never need a scalar tail.
+     */
+    template<typename tT, size_t tN>
+    class FixedVec
+    {
+    public:
+
+        using value_type = tT;
+
+        static constexpr size_t fixed_size = tN;
+        static constexpr size_t padded_size = impl::padded_count<tT, tN>;
+
+        FixedVec(const ::lineal::fill &fill = ::lineal::fill::none)
+        {
+            switch (fill)
+            {
+            case ::lineal::fill::ones:
+                std::fill_n(m_data, tN, 1);
+                break;
+
+            case ::lineal::fill::zeros:
+                std::fill_n(m_data, tN, 0);
+                break;
+
+            default:
+                break;
+            }
+
+            std::fill(m_data + tN, m_data + padded_size, 0);
+        }
+
+        template<typename tOp, typename = std::enable_if_t<is_vec_op<tOp>>>
+        FixedVec &operator=(const tOp &op)
+        {
+            impl::fixed_assign(m_data, op, std::make_index_sequence<tN / impl::PackedTypeHelper<tT>::count>(),
+                               std::make_index_sequence<tN % impl::PackedTypeHelper<tT>::count>());
+            return *this;
+        }
+
+        tT &operator[](const size_t i)
+        {
+            return m_data[i];
+        }
+
+        const tT &operator[](const size_t i) const
+        {
+            return m_data[i];
+        }
+
+        tT *begin()
+        {
+            return m_data;
+        }
+
+        tT *end()
+        {
+            return m_data + tN;
+        }
+
+        constexpr size_t size() const
+        {
+            return tN;
+        }
+
+        constexpr size_t capacity() const
+        {
+            return padded_size;
+        }
+
+        const tT *data() const
+        {
+            return m_data;
+        }
+
+    private:
+
+        alignas(sizeof(impl::PackedType<tT>)) tT m_data[padded_size];
+    };
+
+    template<typename tT, size_t tN>
+    class ConstFixedVec
+    {
+    public:
+
+        using value_type = tT;
+
+        static constexpr size_t fixed_size = tN;
+
+        ConstFixedVec(const tT *auxiliary)
+            : m_raw(auxiliary)
+        {
+        }
+
+        ConstFixedVec(const ConstFixedVec &) = delete;
+
+        const tT &operator[](const size_t i) const
+        {
+            return m_raw[i];
+        }
+
+        const tT *begin() const
+        {
+            return m_raw;
+        }
+
+        const tT *end() const
+        {
+            return m_raw + tN;
+        }
+
+        constexpr size_t size() const
+        {
+            return tN;
+        }
+
+        const tT *data() const
+        {
+            return m_raw;
+        }
+
+    private:
+
+        const tT *m_raw;
+    };
+
+    template<typename tT, size_t tN>
+    class FixedCol : public FixedVec<tT, tN>
+    {
+    public:
+
+        using tParent = FixedVec<tT, tN>;
+
+        using tParent::tParent;
+        using tParent::operator=;
+
+        ConstFixedRow<tT, tN> t() const
+        {
+            return ConstFixedRow<tT, tN>(this->data());
+        }
+    };
+
+    template<typename tT, size_t tN>
+    class ConstFixedCol : public ConstFixedVec<tT, tN>
+    {
+    public:
+
+        using tParent = ConstFixedVec<tT, tN>;
+
+        using tParent::tParent;
+
+        ConstFixedCol(const ConstFixedCol &) = delete;
+
+        ConstFixedRow<tT, tN> t() const
+        {
+            return ConstFixedRow<tT, tN>(this->data());
+        }
+    };
+
+    template<typename tT, size_t tN>
+    class FixedRow : public FixedVec<tT, tN>
+    {
+    public:
+
+        using tParent = FixedVec<tT, tN>;
+
+        using tParent::tParent;
+        using tParent::operator=;
+
+        ConstFixedCol<tT, tN> t() const
+        {
+            return ConstFixedCol<tT, tN>(this->data());
+        }
+    };
+
+    template<typename tT, size_t tN>
+    class ConstFixedRow : public ConstFixedVec<tT, tN>
+    {
+    public:
+
+        using tParent = ConstFixedVec<tT, tN>;
+
+        using tParent::tParent;
+
+        ConstFixedRow(const ConstFixedRow &) = delete;
+
+        ConstFixedCol<tT, tN> t() const
+        {
+            return ConstFixedCol<tT, tN>(this->data());
+        }
+    };
+
+    template<Orientation tOrient, typename tT, size_t tN>
+    struct VecOrientationHelper<tOrient, FixedRow<tT, tN>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationRow;
+        }
+    };
+
+    template<Orientation tOrient, typename tT, size_t tN>
+    struct VecOrientationHelper<tOrient, ConstFixedRow<tT, tN>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationRow;
+        }
+    };
+
+    template<Orientation tOrient, typename tT, size_t tN>
+    struct VecOrientationHelper<tOrient, FixedCol<tT, tN>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationCol;
+        }
+    };
+
+    template<Orientation tOrient, typename tT, size_t tN>
+    struct VecOrientationHelper<tOrient, ConstFixedCol<tT, tN>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationCol;
+        }
+    };
+
+    template<typename tT, size_t tN>
+    constexpr bool is_raw_vec<FixedRow<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_raw_vec<ConstFixedRow<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_raw_vec<FixedCol<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_raw_vec<ConstFixedCol<tT, tN>> = true;
+
+    template<typename tT, size_t tN>
+    constexpr bool is_fixed_vec<FixedRow<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_fixed_vec<ConstFixedRow<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_fixed_vec<FixedCol<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool is_fixed_vec<ConstFixedCol<tT, tN>> = true;
+
+    // Only owning fixed vectors guarantee zeroed storage up to a whole register.
+    template<typename>
+    constexpr bool has_zero_padding = false;
+    template<typename tT, size_t tN>
+    constexpr bool has_zero_padding<FixedRow<tT, tN>> = true;
+    template<typename tT, size_t tN>
+    constexpr bool has_zero_padding<FixedCol<tT, tN>> = true;
+
+    namespace impl
+    {
+        template<typename tVec, typename = void>
+        struct FixedSizeOf
+        {
+            static constexpr size_t value = 0;
+        };
+
+        template<typename tVec>
+        struct FixedSizeOf<tVec, std::enable_if_t<is_fixed_vec<tVec>>>
+        {
+            static constexpr size_t value = tVec::fixed_size;
+        };
+
+        template<typename tOp>
+        struct FixedSizeOf<tOp, std::void_t<typename tOp::tOperand>>
+        {
+            static constexpr size_t value = FixedSizeOf<typename tOp::tOperand>::value;
+        };
+
+        // Compile-time length of a fixed vector, or of the fixed vector at the bottom of an expression; 0 otherwise.
+        template<typename tVec>
+        constexpr size_t fixed_size_of = FixedSizeOf<tVec>::value;
+
+        // Owning fixed vectors keep their storage register aligned; const views may point anywhere.
+        template<typename tVec>
+        auto fixed_load(const tVec &v, size_t i)
+        {
+            PackedType<typename tVec::value_type> packed;
+
+            if constexpr(has_zero_padding<tVec>)
+            {
+                packed = ::simdpp::load(v.data() + i);
+            }
+            else
+            {
+                packed = ::simdpp::load_u(v.data() + i);
+            }
+
+            return packed;
+        }
+
+        template<typename tRow, typename tCol, size_t... tI>
+        auto fixed_inprod_packed(const tRow &row, const tCol &col, std::index_sequence<tI...>)
+        {
+            using value_type = typename tRow::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+
+            value_type init = 0;
+            PackedType<value_type> acc = ::simdpp::load_splat(&init);
+
+            ((acc = ::simdpp::add(::simdpp::mul(fixed_load(row, tI * count), fixed_load(col, tI * count)), acc)), ...);
+
+            return value_type(::simdpp::reduce_add(acc));
+        }
+
+        template<size_t tOffset, typename tRow, typename tCol, size_t... tJ>
+        auto fixed_inprod_tail(const tRow &row, const tCol &col, std::index_sequence<tJ...>)
+        {
+            using value_type = typename tRow::value_type;
+            return (value_type(0) + ... + (row[tOffset + tJ] * col[tOffset + tJ]));
+        }
+
+        template<typename tRow, typename tCol>
+        auto fixed_inprod(const tRow &row, const tCol &col)
+        {
+            using value_type = typename tRow::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+            constexpr size_t size = tRow::fixed_size;
+
+            static_assert(size == tCol::fixed_size, "fixed vectors must have the same length");
+            static_assert(std::is_same_v<value_type, typename tCol::value_type>, "fixed vectors must have the same element type");
+
+            if constexpr(has_zero_padding<tRow> && has_zero_padding<tCol>)
+            {
+                return fixed_inprod_packed(row, col, std::make_index_sequence<padded_count<value_type, size> / count>());
+            }
+            else
+            {
+                return fixed_inprod_packed(row, col, std::make_index_sequence<size / count>()) +
+                       fixed_inprod_tail<size / count * count>(row, col, std::make_index_sequence<size % count>());
+            }
+        }
+
+        template<typename tVec, size_t... tI>
+        auto fixed_sum_packed(const tVec &v, std::index_sequence<tI...>)
+        {
+            using value_type = typename tVec::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+
+            value_type init = 0;
+            PackedType<value_type> acc = ::simdpp::load_splat(&init);
+
+            ((acc = ::simdpp::add(fixed_load(v, tI * count), acc)), ...);
+
+            return value_type(::simdpp::reduce_add(acc));
+        }
+
+        template<size_t tOffset, typename tVec, size_t... tJ>
+        auto fixed_sum_tail(const tVec &v, std::index_sequence<tJ...>)
+        {
+            using value_type = typename tVec::value_type;
+            return (value_type(0) + ... + v[tOffset + tJ]);
+        }
+
+        template<typename tVec>
+        auto fixed_sum(const tVec &v)
+        {
+            using value_type = typename tVec::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+            constexpr size_t size = tVec::fixed_size;
+
+            if constexpr(has_zero_padding<tVec>)
+            {
+                return fixed_sum_packed(v, std::make_index_sequence<padded_count<value_type, size> / count>());
+            }
+            else
+            {
+                return fixed_sum_packed(v, std::make_index_sequence<size / count>()) +
+                       fixed_sum_tail<size / count * count>(v, std::make_index_sequence<size % count>());
+            }
+        }
+    }
+}
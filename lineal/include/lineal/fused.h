@@ -0,0 +1,258 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/async.h"
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/parallel.h"
+#include "lineal/vec.h"
+#include "lineal/vec_scalar_op.h"
+
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
+namespace lineal
+{
+    namespace impl
+    {
+        template<typename tT, typename tOp>
+        struct FusedAssign
+        {
+            using value_type = tT;
+
+            tT *out;
+            Capture<tOp> op;
+
+            struct State
+            {
+                tT *out;
+                const tOp &op;
+                WrapSIMD<tOp> wrapped;
+                bool aligned;
+
+                void packed(size_t i)
+                {
+                    if (aligned)
+                    {
+                        ::simdpp::store(out + i * PackedTypeHelper<tT>::count, wrapped.load_packed(i));
+                    }
+                    else
+                    {
+                        ::simdpp::store_u(out + i * PackedTypeHelper<tT>::count, wrapped.load_packed(i));
+                    }
+                }
+
+                void scalar(size_t i)
+                {
+                    out[i] = op[i];
+                }
+            };
+
+            size_t size() const
+            {
+                return op.get().size();
+            }
+
+            void prepare(size_t)
+            {
+            }
+
+            State state() const
+            {
+                return State{out, op.get(), WrapSIMD<tOp>(op.get()), is_register_aligned(out)};
+            }
+
+            void merge(size_t, const State &)
+            {
+            }
+
+            void finish()
+            {
+            }
+        };
+
+        template<typename tT, typename tVec>
+        struct FusedSum
+        {
+            using value_type = tT;
+            using tPacked = PackedType<tT>;
+
+            tT &result;
+            Capture<tVec> vec;
+            std::vector<tT> partials;
+
+            struct State
+            {
+                const tVec &vec;
+                tPacked acc;
+                tT tail;
+
+                void packed(size_t i)
+                {
+                    tPacked v;
+                    SIMDAccess::load_operand(vec, i * PackedTypeHelper<tT>::count, v);
+                    acc = ::simdpp::add(acc, v);
+                }
+
+                void scalar(size_t i)
+                {
+                    tail += vec[i];
+                }
+            };
+
+            size_t size() const
+            {
+                return vec.get().size();
+            }
+
+            void prepare(size_t chunks)
+            {
+                partials.assign(chunks, tT(0));
+            }
+
+            State state() const
+            {
+                const tT zero = 0;
+                return State{vec.get(), ::simdpp::load_splat(&zero), zero};
+            }
+
+            void merge(size_t chunk, const State &state)
+            {
+                partials[chunk] = ::simdpp::reduce_add(state.acc) + state.tail;
+            }
+
+            void finish()
+            {
+                result = 0;
+
+                for (const tT &partial : partials)
+                {
+                    result += partial;
+                }
+            }
+        };
+
+        template<typename tTerms>
+        void fused_range(tTerms &terms, size_t chunk, size_t begin, size_t end)
+        {
+            using tFirst = std::decay_t<std::tuple_element_t<0, tTerms>>;
+            constexpr size_t count = PackedTypeHelper<typename tFirst::value_type>::count;
+
+            auto states = std::apply([](const auto &... term)
+            {
+                return std::make_tuple(term.state()...);
+            }, terms);
+
+            const size_t last = end / count * count;
+
+            // Every term consumes the same register index before moving on, and vectors read by several terms are loaded
+            // once per register, so every term sees its inputs as they were before the register was written.
+            {
+                SharedLoads loads;
+
+                for (size_t i = begin / count, iEnd = last / count; i < iEnd; ++i)
+                {
+                    loads.count = 0;
+
+                    std::apply([i](auto &... state)
+                    {
+                        (state.packed(i), ...);
+                    }, states);
+                }
+            }
+
+            for (size_t i = std::max(begin, last); i < end; ++i)
+            {
+                std::apply([i](auto &... state)
+                {
+                    (state.scalar(i), ...);
+                }, states);
+            }
+
+            std::apply([&](auto &... term)
+            {
+                std::apply([&](auto &... state)
+                {
+                    (term.merge(chunk, state), ...);
+                }, states);
+            }, terms);
+        }
+    }
+
+    template<typename tT, typename tOp, typename = std::enable_if_t<is_vec<tOp>>>
+    auto assign_to(Vec<tT> &out, const tOp &op)
+    {
+        LINEAL_ASSERT(out.size() == op.size(), "assign_to needs an output of the expression's size");
+        return impl::FusedAssign<tT, tOp> {out.begin(), impl::Capture<tOp>(op)};
+    }
+
+    template<typename tVec, typename = std::enable_if_t<is_vec<tVec>>>
+    auto sum_into(typename tVec::value_type &result, const tVec &v)
+    {
+        return impl::FusedSum<typename tVec::value_type, tVec> {result, impl::Capture<tVec>(v), {}};
+    }
+
+    /**
+     * Evaluates several assignments and reductions over vectors of the same length in a single blocked loop, e.g.
+     *     fused(assign_to(r1, a * 2.0 + 1.0), assign_to(r2, a / 3.0), sum_into(s, a));
+     * reads `a` from memory once instead of three times. All terms must share one element type.
+     */
+    template<typename... tTerms>
+    void fused(tTerms &&... terms)
+    {
+        auto all = std::forward_as_tuple(terms...);
+        using tFirst = std::decay_t<std::tuple_element_t<0, std::tuple<tTerms...>>>;
+        using value_type = typename tFirst::value_type;
+
+        static_assert((std::is_same_v<typename std::decay_t<tTerms>::value_type, value_type> && ...),
+                      "fused terms must share one element type");
+
+        const size_t count = std::get<0>(all).size();
+        LINEAL_ASSERT(((terms.size() == count) && ...), "fused terms must have equal sizes");
+        LINEAL_COUNT(fused_elements, count);
+        LINEAL_TRACE(fused, count);
+        constexpr size_t grain = impl::chunk_size<value_type>();
+        std::shared_ptr<impl::ThreadPool> executor = impl::use_parallel(count, grain) ? impl::pool() : nullptr;
+        const size_t chunks = executor ? (count + grain - 1) / grain : 1;
+
+        (terms.prepare(chunks), ...);
+
+        if (!executor)
+        {
+            impl::fused_range(all, 0, 0, count);
+        }
+        else
+        {
+            impl::run_chunks(*executor, chunks, [&](size_t chunk)
+            {
+                impl::fused_range(all, chunk, chunk * grain, std::min(count, (chunk + 1) * grain));
+            });
+        }
+
+        (terms.finish(), ...);
+    }
+}
@@ -24,6 +24,22 @@
  * @endcond
  */
 #pragma once
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/parallel.h"
+#include "lineal/async.h"
+#include "lineal/eval.h"
 #include "lineal/vec_scalar_op.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/strided_vec.h"
+#include "lineal/unary.h"
+#include "lineal/compare.h"
 #include "lineal/vec_vec_op.h"
 #include "lineal/vec.h"
+#include "lineal/transpose.h"
+#include "lineal/cost.h"
+#include "lineal/batch.h"
+#include "lineal/fused.h"
+#include "lineal/numa.h"
+#include "lineal/autotune.h"
+#include "lineal/precompiled.h"
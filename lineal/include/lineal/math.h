@@ -0,0 +1,268 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/simd.h"
+
+#include <cstdint>
+#include <limits>
+
+namespace lineal
+{
+    namespace impl
+    {
+        /**
+         * Constants of the packed exp and log kernels. The exp polynomial is the Taylor series of exp(r) - 1 on
+         * |r| <= ln2 / 2, the log one the series of log(1 + f) in s = f / (2 + f) for mantissas
+         * sqrt(1/2) <= 1 + f < sqrt(2); both are cut where the truncation error drops below half an ulp.
+         */
+        template<typename>
+        struct MathTraits;
+
+        template<>
+        struct MathTraits<double>
+        {
+            using tBits = uint64_t;
+
+            static constexpr size_t mantissa_bits = 52;
+            static constexpr tBits exponent_bias = 1023;
+            static constexpr tBits mantissa_mask = 0x000fffffffffffffULL;
+            static constexpr tBits one_bits = 0x3ff0000000000000ULL;
+            static constexpr tBits magic_bits = 0x4330000000000000ULL;
+            static constexpr double magic = 4503599627370496.0;
+            static constexpr double shifter = 6755399441055744.0;
+
+            static constexpr size_t exp_terms = 13;
+            static constexpr size_t log_terms = 9;
+
+            static constexpr double exp_min = -708.39641853226408;
+            static constexpr double exp_max = 709.43613930310391;
+            static constexpr double ln2_hi = 6.93145751953125e-1;
+            static constexpr double ln2_lo = 1.42860682030941723212e-6;
+        };
+
+        template<>
+        struct MathTraits<float>
+        {
+            using tBits = uint32_t;
+
+            static constexpr size_t mantissa_bits = 23;
+            static constexpr tBits exponent_bias = 127;
+            static constexpr tBits mantissa_mask = 0x007fffffU;
+            static constexpr tBits one_bits = 0x3f800000U;
+            static constexpr tBits magic_bits = 0x4b000000U;
+            static constexpr float magic = 8388608.0f;
+            static constexpr float shifter = 12582912.0f;
+
+            static constexpr size_t exp_terms = 8;
+            static constexpr size_t log_terms = 5;
+
+            static constexpr float exp_min = -87.3365448f;
+            static constexpr float exp_max = 88.3762589f;
+            static constexpr float ln2_hi = 0.693359375f;
+            static constexpr float ln2_lo = -2.12194440e-4f;
+        };
+
+        template<typename tT>
+        using PackedBits = PackedType<typename MathTraits<tT>::tBits>;
+
+        template<typename tPacked, typename tT>
+        tPacked splat(tT value)
+        {
+            return ::simdpp::load_splat(&value);
+        }
+
+        constexpr double factorial(size_t k)
+        {
+            return k == 0 ? 1.0 : double(k) * factorial(k - 1);
+        }
+
+        /**
+         * exp(x) - 1 as 2^n * q + (2^n - 1), with x = n ln2 + r and q the polynomial in r. Keeping the -1 out of the
+         * polynomial keeps the result accurate for small x, which tanh relies on. Inputs must be within
+         * [exp_min, exp_max].
+         */
+        template<typename tT, typename tPacked>
+        void packed_exp_parts(const tPacked &x, tPacked &scale, tPacked &q)
+        {
+            using tTraits = MathTraits<tT>;
+            using tBits = PackedBits<tT>;
+
+            // Adding 1.5 * 2^mantissa_bits rounds x / ln2 to an integer n and leaves it in the low mantissa bits.
+            const tPacked shifter = splat<tPacked>(tTraits::shifter);
+            const tPacked shifted = ::simdpp::add(::simdpp::mul(x, splat<tPacked>(tT(1.4426950408889634))), shifter);
+            const tPacked n = ::simdpp::sub(shifted, shifter);
+
+            const tPacked r = ::simdpp::sub(::simdpp::sub(x, ::simdpp::mul(n, splat<tPacked>(tTraits::ln2_hi))),
+                                          ::simdpp::mul(n, splat<tPacked>(tTraits::ln2_lo)));
+
+            tBits bits = ::simdpp::bit_cast<tBits>(shifted);
+            bits = ::simdpp::add(bits, splat<tBits>(tTraits::exponent_bias));
+            bits = ::simdpp::shift_l<tTraits::mantissa_bits>(bits);
+            scale = ::simdpp::bit_cast<tPacked>(bits);
+
+            tPacked p = splat<tPacked>(tT(1.0 / factorial(tTraits::exp_terms)));
+
+            for (size_t k = tTraits::exp_terms - 1; k >= 1; --k)
+            {
+                p = ::simdpp::add(::simdpp::mul(p, r), splat<tPacked>(tT(1.0 / factorial(k))));
+            }
+
+            q = ::simdpp::mul(p, r);
+        }
+
+        template<typename tT, typename tPacked>
+        tPacked packed_clamp_exp_input(const tPacked &x)
+        {
+            return ::simdpp::min(::simdpp::max(x, splat<tPacked>(MathTraits<tT>::exp_min)), splat<tPacked>(MathTraits<tT>::exp_max));
+        }
+
+        /**
+         * exp(x), within 1.5 ulp of the exact result for double and float. Results below the smallest
+         * normal number flush to zero, and overflow to infinity starts at 709.436 (double) or 88.376 (float), slightly
+         * before the true overflow point. NaN propagates.
+         */
+        template<typename tT, typename tPacked>
+        tPacked packed_exp(const tPacked &x)
+        {
+            using tTraits = MathTraits<tT>;
+
+            tPacked scale, q;
+            packed_exp_parts<tT>(packed_clamp_exp_input<tT>(x), scale, q);
+
+            tPacked result = ::simdpp::add(::simdpp::mul(scale, q), scale);
+            result = ::simdpp::blend(splat<tPacked>(tT(0)), result, ::simdpp::cmp_lt(x, splat<tPacked>(tTraits::exp_min)));
+            result = ::simdpp::blend(splat<tPacked>(std::numeric_limits<tT>::infinity()), result,
+                                   ::simdpp::cmp_gt(x, splat<tPacked>(tTraits::exp_max)));
+
+            return ::simdpp::blend(x, result, ::simdpp::cmp_neq(x, x));
+        }
+
+        // exp(x) - 1 with the same range handling as packed_exp, saturating at -1 for large negative x.
+        template<typename tT, typename tPacked>
+        tPacked packed_expm1(const tPacked &x)
+        {
+            tPacked scale, q;
+            packed_exp_parts<tT>(packed_clamp_exp_input<tT>(x), scale, q);
+
+            const tPacked one = splat<tPacked>(tT(1));
+            return ::simdpp::add(::simdpp::mul(scale, q), ::simdpp::sub(scale, one));
+        }
+
+        /**
+         * Natural logarithm, within 1 ulp of the exact result for double and float. log(0) is -inf, log
+         * of a negative number is NaN, and infinity and NaN propagate. Denormal inputs are not supported.
+         */
+        template<typename tT, typename tPacked>
+        tPacked packed_log(const tPacked &x)
+        {
+            using tTraits = MathTraits<tT>;
+            using tBits = PackedBits<tT>;
+
+            const tBits bits = ::simdpp::bit_cast<tBits>(x);
+            const tBits exponent_bits = ::simdpp::shift_r<tTraits::mantissa_bits>(bits);
+
+            // x = m * 2^e with m in [1, 2); e is turned into a float by placing it in the mantissa of 2^mantissa_bits.
+            tPacked m = ::simdpp::bit_cast<tPacked>(::simdpp::bit_or(::simdpp::bit_and(bits, splat<tBits>(tTraits::mantissa_mask)),
+                                                  splat<tBits>(tTraits::one_bits)));
+            tPacked e = ::simdpp::sub(::simdpp::bit_cast<tPacked>(::simdpp::bit_or(exponent_bits, splat<tBits>(tTraits::magic_bits))),
+                                    splat<tPacked>(tT(tTraits::magic + tTraits::exponent_bias)));
+
+            // Centre the mantissa on 1, so that |f| <= 3 - 2 sqrt(2).
+            const auto upper = ::simdpp::cmp_gt(m, splat<tPacked>(tT(1.4142135623730951)));
+            m = ::simdpp::blend(::simdpp::mul(m, splat<tPacked>(tT(0.5))), m, upper);
+            e = ::simdpp::blend(::simdpp::add(e, splat<tPacked>(tT(1))), e, upper);
+
+            // log(1 + f) = f - f^2 / 2 + s (f^2 / 2 + R) with s = f / (2 + f), which keeps f = m - 1 exact.
+            const tPacked f = ::simdpp::sub(m, splat<tPacked>(tT(1)));
+            const tPacked s = ::simdpp::div(f, ::simdpp::add(f, splat<tPacked>(tT(2))));
+            const tPacked z = ::simdpp::mul(s, s);
+            const tPacked half_f2 = ::simdpp::mul(::simdpp::mul(f, f), splat<tPacked>(tT(0.5)));
+
+            tPacked p = splat<tPacked>(tT(2.0 / (2 * tTraits::log_terms + 1)));
+
+            for (size_t k = tTraits::log_terms - 1; k >= 1; --k)
+            {
+                p = ::simdpp::add(::simdpp::mul(p, z), splat<tPacked>(tT(2.0 / (2 * k + 1))));
+            }
+
+            const tPacked r = ::simdpp::add(::simdpp::mul(s, ::simdpp::add(half_f2, ::simdpp::mul(z, p))),
+                                            ::simdpp::mul(e, splat<tPacked>(tTraits::ln2_lo)));
+            tPacked result = ::simdpp::add(::simdpp::mul(e, splat<tPacked>(tTraits::ln2_hi)),
+                                           ::simdpp::sub(f, ::simdpp::sub(half_f2, r)));
+
+            const tT infinity = std::numeric_limits<tT>::infinity();
+
+            result = ::simdpp::blend(splat<tPacked>(std::numeric_limits<tT>::quiet_NaN()), result,
+                                   ::simdpp::cmp_lt(x, splat<tPacked>(tT(0))));
+            result = ::simdpp::blend(splat<tPacked>(-infinity), result, ::simdpp::cmp_eq(x, splat<tPacked>(tT(0))));
+            result = ::simdpp::blend(x, result, ::simdpp::cmp_eq(x, splat<tPacked>(infinity)));
+
+            return ::simdpp::blend(x, result, ::simdpp::cmp_neq(x, x));
+        }
+
+        // Correctly rounded, as it maps to the hardware instruction.
+        template<typename tT, typename tPacked>
+        tPacked packed_sqrt(const tPacked &x)
+        {
+            return ::simdpp::sqrt(x);
+        }
+
+        // 1 / sqrt(x) through a full-precision square root and division, within 1.5 ulp.
+        template<typename tT, typename tPacked>
+        tPacked packed_rsqrt(const tPacked &x)
+        {
+            return ::simdpp::div(splat<tPacked>(tT(1)), ::simdpp::sqrt(x));
+        }
+
+        /**
+         * tanh(x) = -expm1(-2|x|) / (expm1(-2|x|) + 2) with the sign of x restored; within 3 ulp. Going through expm1
+         * keeps small arguments accurate, where 1 - 2 / (exp(2x) + 1) would cancel.
+         */
+        template<typename tT, typename tPacked>
+        tPacked packed_tanh(const tPacked &x)
+        {
+            using tBits = PackedBits<tT>;
+
+            const tBits sign_mask = ::simdpp::bit_cast<tBits>(splat<tPacked>(tT(-0.0)));
+            const tBits sign = ::simdpp::bit_and(::simdpp::bit_cast<tBits>(x), sign_mask);
+            const tPacked magnitude = ::simdpp::bit_cast<tPacked>(::simdpp::bit_andnot(::simdpp::bit_cast<tBits>(x), sign_mask));
+
+            const tPacked e = packed_expm1<tT>(::simdpp::mul(magnitude, splat<tPacked>(tT(-2))));
+            const tPacked t = ::simdpp::div(::simdpp::sub(splat<tPacked>(tT(0)), e), ::simdpp::add(e, splat<tPacked>(tT(2))));
+            const tPacked result = ::simdpp::bit_cast<tPacked>(::simdpp::bit_or(::simdpp::bit_cast<tBits>(t), sign));
+
+            return ::simdpp::blend(x, result, ::simdpp::cmp_neq(x, x));
+        }
+
+        // 1 / (1 + exp(-x)); within 3 ulp, saturating to exactly 0 and 1.
+        template<typename tT, typename tPacked>
+        tPacked packed_sigmoid(const tPacked &x)
+        {
+            const tPacked one = splat<tPacked>(tT(1));
+            return ::simdpp::div(one, ::simdpp::add(one, packed_exp<tT>(::simdpp::sub(splat<tPacked>(tT(0)), x))));
+        }
+    }
+}
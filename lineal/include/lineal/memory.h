@@ -24,14 +24,91 @@
  * @endcond
  */
 #pragma once
+#include "lineal/counters.h"
 #include "lineal/types.h"
 
+#include <algorithm>
+#include <atomic>
+#include <memory_resource>
+#include <new>
+
+// Opt-in inline storage for short vectors, in bytes. Every vector grows by this much (plus alignment to a cache
+// line) whether it uses the buffer or not, so it is off by default.
+#ifndef LINEAL_SMALL_BUFFER_BYTES
+#   define LINEAL_SMALL_BUFFER_BYTES 0
+#endif
+
 namespace lineal
 {
     namespace impl
     {
+#if defined(LINEAL_PAD_STORAGE)
+        constexpr bool pad_storage = true;
+#else
+        constexpr bool pad_storage = false;
+#endif
+
+        // With LINEAL_COPY_ON_WRITE heap buffers carry a reference count, so `share()` is free until the first write.
+        // Without it no count is allocated or touched, and `share()` copies.
+#if defined(LINEAL_COPY_ON_WRITE)
+        constexpr bool copy_on_write = true;
+#else
+        constexpr bool copy_on_write = false;
+#endif
+
+        // With LINEAL_PAD_STORAGE every allocation is rounded up to a whole cache line, which is a multiple of every
+        // register width, and the padding is kept zero so kernels can run whole registers up to the end.
         template<typename tT>
-        struct AlignedAllocator
+        constexpr size_t padded_capacity(size_t size)
+        {
+            if constexpr(pad_storage)
+            {
+                constexpr size_t line = 64 / sizeof(tT) == 0 ? 1 : 64 / sizeof(tT);
+                return (size + line - 1) / line * line;
+            }
+            else
+            {
+                return size;
+            }
+        }
+
+        // Number of elements kept inline in Memory before falling back to the heap.
+        template<typename tT>
+        constexpr size_t small_buffer_count = LINEAL_SMALL_BUFFER_BYTES / sizeof(tT);
+
+        template<typename tT, size_t tCount>
+        struct InlineStorage
+        {
+            alignas(64) tT m_inline[tCount];
+
+            tT *inline_data()
+            {
+                return m_inline;
+            }
+
+            const tT *inline_data() const
+            {
+                return m_inline;
+            }
+        };
+
+        // Without a small buffer the storage is an empty base and adds nothing to the size of Memory.
+        template<typename tT>
+        struct InlineStorage<tT, 0>
+        {
+            tT *inline_data()
+            {
+                return nullptr;
+            }
+
+            const tT *inline_data() const
+            {
+                return nullptr;
+            }
+        };
+
+        template<typename tT>
+        struct SystemAllocator
         {
 #if   defined(LINEAL_USE_TBB_ALLOC)
             static tT *aligned_malloc(size_t size)
@@ -59,7 +136,7 @@ namespace lineal
                 tT *mem = NULL;
 
                 const size_t byte_count = sizeof(tT) * size_t(size);
-                const size_t alignment = (byte_count >= size_t(1024)) ? size_t(64) : size_t(16);
+                const size_t alignment = (byte_count >= size_t(1024) || pad_storage) ? size_t(64) : size_t(16);
 
                 int status = posix_memalign((void **)&mem, ((alignment >= sizeof(void *)) ? alignment : sizeof(void *)), byte_count);
 
@@ -74,7 +151,7 @@ namespace lineal
             static tT *aligned_malloc(size_t size)
             {
                 const size_t byte_count = sizeof(tT) * size_t(size);
-                const size_t alignment = (byte_count >= size_t(1024)) ? size_t(64) : size_t(16);
+                const size_t alignment = (byte_count >= size_t(1024) || pad_storage) ? size_t(64) : size_t(16);
 
                 return (tT *)_aligned_malloc(byte_count, alignment);
             }
@@ -97,15 +174,45 @@ namespace lineal
         };
 
         template<typename tT>
-        class Memory
+        struct AlignedAllocator
+        {
+            static tT *aligned_malloc(size_t size)
+            {
+                LINEAL_COUNT(allocations, 1);
+                LINEAL_COUNT(allocated_bytes, sizeof(tT) * size);
+
+                return SystemAllocator<tT>::aligned_malloc(size);
+            }
+
+            static void aligned_free(tT *mem)
+            {
+                LINEAL_COUNT(frees, 1);
+
+                SystemAllocator<tT>::aligned_free(mem);
+            }
+        };
+
+        /**
+         * Owning storage of a vector. With LINEAL_SMALL_BUFFER_BYTES set, payloads up to `small_buffer_count` elements
+         * live inline; all others live on the heap. With LINEAL_COPY_ON_WRITE a cache line in front of every heap buffer
+         * holds an atomic reference count, so `share()` can hand out references without copying. Writers call `detach()`
+         * first, which copies only when the buffer is shared.
+         * Heap buffers come from `resource` when one is given, and from AlignedAllocator otherwise.
+         */
+        template<typename tT>
+        class Memory : private InlineStorage<tT, small_buffer_count<tT>>
         {
         public:
 
-            Memory(size_t size, const ::lineal::fill &fill)
-                : m_memory(AlignedAllocator<tT>::aligned_malloc(size)),
+            Memory(size_t size, const ::lineal::fill &fill, std::pmr::memory_resource *resource = nullptr)
+                : m_memory(fits_inline(size) ? this->inline_data() : allocate(padded_capacity<tT>(size), resource)),
                   m_size(size),
-                  m_owned(true)
+                  m_capacity(padded_capacity<tT>(size)),
+                  m_owned(!is_inline()),
+                  m_resource(resource)
             {
+                std::fill(m_memory + m_size, m_memory + m_capacity, 0);
+
                 switch (fill)
                 {
                 case ::lineal::fill::ones:
@@ -126,31 +233,116 @@ namespace lineal
             Memory(tT *auxiliary, size_t size)
                 : m_memory(auxiliary),
                   m_size(size),
-                  m_owned(false)
+                  m_capacity(size),
+                  m_owned(false),
+                  m_resource(nullptr)
             {
             }
 
             Memory(Memory &&other)
-                : m_memory(other.steal()),
+                : m_memory(other.m_memory),
                   m_size(other.m_size),
-                  m_owned(true)
+                  m_capacity(other.m_capacity),
+                  m_owned(other.m_owned),
+                  m_resource(other.m_resource)
             {
+                take_inline(other);
+                other.m_owned = false;
+            }
+
+            Memory &operator=(Memory &&other)
+            {
+                if (this != &other)
+                {
+                    release();
+
+                    m_memory = other.m_memory;
+                    m_size = other.m_size;
+                    m_capacity = other.m_capacity;
+                    m_owned = other.m_owned;
+                    m_resource = other.m_resource;
+
+                    take_inline(other);
+                    other.m_owned = false;
+                }
+
+                return *this;
             }
 
             ~Memory()
             {
-                if (m_owned)
+                release();
+            }
+
+            // Returns a reference to the same heap buffer. Inline payloads, and every payload without copy-on-write, are
+            // deep-copied; auxiliary memory yields another non-owning view.
+            Memory share() const
+            {
+                if (!m_owned && !is_inline())
                 {
-                    AlignedAllocator<tT>::aligned_free(m_memory);
+                    return Memory(m_memory, m_size);
+                }
+
+                if (!copy_on_write || is_inline())
+                {
+                    Memory copy(m_size, ::lineal::fill::none, m_resource);
+                    std::copy_n(m_memory, m_capacity, copy.m_memory);
+                    return copy;
+                }
+
+                header(m_memory).fetch_add(1, std::memory_order_relaxed);
+                return Memory(m_memory, m_size, m_capacity, m_resource);
+            }
+
+            bool shared() const
+            {
+                if constexpr(copy_on_write)
+                {
+                    return m_owned && header(m_memory).load(std::memory_order_acquire) > 1;
+                }
+                else
+                {
+                    return false;
                 }
             }
 
+            // Gives this object its own copy of a shared buffer before it is written to.
+            void detach()
+            {
+                if (shared())
+                {
+                    tT *copy = allocate(m_capacity, m_resource);
+                    std::copy_n(m_memory, m_capacity, copy);
+
+                    release();
+
+                    m_memory = copy;
+                    m_owned = true;
+                }
+            }
+
+            // Hands a plain AlignedAllocator buffer over to the caller. Inline payloads, resource buffers and buffers with
+            // a reference count in front of them are copied out.
             tT *steal()
             {
+                if ((m_owned && (copy_on_write || m_resource)) || is_inline())
+                {
+                    tT *plain = AlignedAllocator<tT>::aligned_malloc(m_capacity);
+                    std::copy_n(m_memory, m_capacity, plain);
+
+                    release();
+                    m_memory = plain;
+                }
+
                 m_owned = false;
                 return m_memory;
             }
 
+            bool is_inline() const
+            {
+                return small_buffer_count<tT> > 0 && m_memory == this->inline_data();
+            }
+
             tT *raw()
             {
                 return m_memory;
@@ -161,6 +353,11 @@ namespace lineal
                 return m_size;
             }
 
+            size_t capacity() const
+            {
+                return m_capacity;
+            }
+
             const tT *begin() const
             {
                 return m_memory;
@@ -178,9 +375,82 @@ namespace lineal
 
         private:
 
+            // Elements reserved in front of every heap buffer for the reference count; a whole cache line keeps the
+            // payload aligned.
+            static constexpr size_t header_count = copy_on_write ? (64 + sizeof(tT) - 1) / sizeof(tT) : 0;
+
+            // Cache line alignment for buffers from a memory resource, which covers every register width.
+            static constexpr size_t resource_alignment = 64;
+
+            Memory(tT *shared, size_t size, size_t capacity, std::pmr::memory_resource *resource)
+                : m_memory(shared),
+                  m_size(size),
+                  m_capacity(capacity),
+                  m_owned(true),
+                  m_resource(resource)
+            {
+            }
+
+            static constexpr bool fits_inline(size_t size)
+            {
+                return small_buffer_count<tT> > 0 && padded_capacity<tT>(size) <= small_buffer_count<tT>;
+            }
+
+            static std::atomic<size_t> &header(tT *memory)
+            {
+                return *reinterpret_cast<std::atomic<size_t> *>(memory - header_count);
+            }
+
+            static tT *allocate(size_t capacity, std::pmr::memory_resource *resource)
+            {
+                if (resource)
+                {
+                    LINEAL_COUNT(resource_allocations, 1);
+                }
+
+                tT *base = resource ? static_cast<tT *>(resource->allocate((capacity + header_count) * sizeof(tT), resource_alignment))
+                           : AlignedAllocator<tT>::aligned_malloc(capacity + header_count);
+
+                if constexpr(copy_on_write)
+                {
+                    new (base) std::atomic<size_t>(1);
+                }
+
+                return base + header_count;
+            }
+
+            void take_inline(const Memory &other)
+            {
+                if (other.is_inline())
+                {
+                    std::copy_n(other.inline_data(), m_capacity, this->inline_data());
+                    m_memory = this->inline_data();
+                }
+            }
+
+            void release()
+            {
+                if (m_owned && (!copy_on_write || header(m_memory).fetch_sub(1, std::memory_order_acq_rel) == 1))
+                {
+                    if (m_resource)
+                    {
+                        LINEAL_COUNT(frees, 1);
+                        m_resource->deallocate(m_memory - header_count, (m_capacity + header_count) * sizeof(tT), resource_alignment);
+                    }
+                    else
+                    {
+                        AlignedAllocator<tT>::aligned_free(m_memory - header_count);
+                    }
+                }
+
+                m_owned = false;
+            }
+
             tT *m_memory;
             size_t m_size;
+            size_t m_capacity;
             bool m_owned;
+            std::pmr::memory_resource *m_resource;
         };
     }
 }
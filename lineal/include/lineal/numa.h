@@ -0,0 +1,553 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/memory.h"
+#include "lineal/parallel.h"
+#include "lineal/vec.h"
+#include "lineal/vec_vec_op.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+// Define LINEAL_USE_NUMA and link against libnuma to bind partitions to NUMA nodes.
+#if defined(LINEAL_USE_NUMA)
+#include <numa.h>
+#endif
+
+namespace lineal
+{
+    namespace impl
+    {
+        // Nodes are numbered by their position in `ids`; node IDs themselves need not be dense.
+        struct NumaTopology
+        {
+            std::vector<int> ids;
+            std::vector<std::vector<int>> cpus;
+
+            NumaTopology()
+            {
+#if defined(LINEAL_USE_NUMA)
+                if (numa_available() >= 0)
+                {
+                    struct bitmask *allowed = numa_get_mems_allowed();
+                    struct bitmask *mask = numa_allocate_cpumask();
+
+                    for (int node = 0, last = numa_max_node(); node <= last; ++node)
+                    {
+                        if (!numa_bitmask_isbitset(allowed, node))
+                        {
+                            continue;
+                        }
+
+                        std::vector<int> node_cpus;
+
+                        if (numa_node_to_cpus(node, mask) == 0)
+                        {
+                            for (int cpu = 0, end = numa_num_configured_cpus(); cpu < end; ++cpu)
+                            {
+                                if (numa_bitmask_isbitset(mask, cpu))
+                                {
+                                    node_cpus.push_back(cpu);
+                                }
+                            }
+                        }
+
+                        ids.push_back(node);
+                        cpus.push_back(node_cpus);
+                    }
+
+                    numa_free_cpumask(mask);
+                    numa_free_nodemask(allowed);
+                }
+#endif
+
+                if (cpus.empty())
+                {
+                    ids.push_back(0);
+                    cpus.emplace_back();
+                }
+            }
+
+            size_t nodes() const
+            {
+                return cpus.size();
+            }
+        };
+
+        inline const NumaTopology &numa_topology()
+        {
+            static NumaTopology topology;
+            return topology;
+        }
+
+        struct NumaPools
+        {
+            std::mutex mutex;
+            size_t threads = 0;
+            std::vector<std::shared_ptr<ThreadPool>> pools;
+        };
+
+        /**
+         * Returns a pool whose workers are pinned to the CPUs of `node`, or the shared pool without NUMA support. The
+         * node pools split get_num_threads() - 1 workers between the nodes by CPU count, so together with the calling
+         * thread they never run more threads than configured. A node left without workers returns null.
+         */
+        inline std::shared_ptr<ThreadPool> node_pool(size_t node)
+        {
+            const NumaTopology &topology = numa_topology();
+
+            if (topology.cpus[node].empty())
+            {
+                return pool();
+            }
+
+            static NumaPools state;
+            std::lock_guard<std::mutex> lock(state.mutex);
+
+            const size_t threads = get_num_threads();
+
+            if (state.threads != threads)
+            {
+                state.threads = threads;
+                state.pools.assign(topology.nodes(), nullptr);
+            }
+
+            if (!state.pools[node])
+            {
+                size_t total = 0;
+                size_t before = 0;
+
+                for (size_t i = 0; i < topology.nodes(); ++i)
+                {
+                    total += topology.cpus[i].size();
+                    before += i < node ? topology.cpus[i].size() : 0;
+                }
+
+                // Cumulative rounding hands out every worker exactly once.
+                const size_t workers = (threads - 1) * (before + topology.cpus[node].size()) / total - (threads - 1) * before / total;
+
+                if (workers == 0)
+                {
+                    return nullptr;
+                }
+
+                state.pools[node] = make_pool(workers, topology.cpus[node]);
+            }
+
+            return state.pools[node];
+        }
+
+        template<typename tT>
+        struct NumaAllocator
+        {
+            static tT *allocate(size_t size, size_t node)
+            {
+                tT *mem = nullptr;
+
+#if defined(LINEAL_USE_NUMA)
+                if (numa_available() >= 0)
+                {
+                    mem = static_cast<tT *>(numa_alloc_onnode(sizeof(tT) * size, numa_topology().ids[node]));
+                }
+                else
+#endif
+                {
+                    (void)node;
+                    mem = AlignedAllocator<tT>::aligned_malloc(size);
+                }
+
+                if (!mem)
+                {
+                    throw std::bad_alloc();
+                }
+
+                return mem;
+            }
+
+            static void free(tT *mem, size_t size)
+            {
+#if defined(LINEAL_USE_NUMA)
+                if (numa_available() >= 0)
+                {
+                    numa_free(mem, sizeof(tT) * size);
+                    return;
+                }
+#endif
+                (void)size;
+                AlignedAllocator<tT>::aligned_free(mem);
+            }
+        };
+
+        template<typename tT>
+        struct Partition
+        {
+            tT *data;
+            size_t offset;
+            size_t size;
+            size_t node;
+        };
+
+        /**
+         * Runs map(partition index, begin, end) for chunks of every partition on threads of the node that owns it, and
+         * combines the partial results in order. The calling thread runs every chunk no worker has started yet and then
+         * blocks until the rest are done. Vectors below the parallel threshold are reduced on the calling thread, and
+         * the first exception thrown by a chunk is rethrown once every chunk has finished.
+         */
+        template<typename tT, typename tPartitions, typename tMap>
+        tT partitioned_reduce(const tPartitions &partitions, const tMap &map)
+        {
+            struct Job
+            {
+                size_t partition;
+                size_t begin;
+                size_t end;
+            };
+
+            constexpr size_t grain = chunk_size<tT>();
+            std::vector<Job> jobs;
+            size_t count = 0;
+
+            for (size_t p = 0; p < partitions.size(); ++p)
+            {
+                for (size_t begin = 0; begin < partitions[p].size; begin += grain)
+                {
+                    jobs.push_back(Job{p, begin, std::min(partitions[p].size, begin + grain)});
+                }
+
+                count += partitions[p].size;
+            }
+
+            // Tasks left in a queue may run after this call returns, so they share ownership of the state.
+            struct State
+            {
+                std::vector<tT> partials;
+                std::vector<std::atomic<bool>> claimed;
+                size_t remaining;
+                std::exception_ptr error;
+                std::mutex mutex;
+                std::condition_variable done;
+
+                explicit State(size_t jobs)
+                    : partials(jobs, tT(0)),
+                      claimed(jobs),
+                      remaining(jobs)
+                {}
+            };
+
+            const bool parallel = use_parallel(count, grain);
+            const auto state = std::make_shared<State>(jobs.size());
+
+            auto run = [state, &jobs, &map](size_t j)
+            {
+                if (state->claimed[j].exchange(true, std::memory_order_acq_rel))
+                {
+                    return;
+                }
+
+                std::exception_ptr error;
+
+                try
+                {
+                    state->partials[j] = map(jobs[j].partition, jobs[j].begin, jobs[j].end);
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->error = state->error ? state->error : error;
+
+                if (--state->remaining == 0)
+                {
+                    state->done.notify_all();
+                }
+            };
+
+            if (parallel)
+            {
+                for (size_t j = 0; j < jobs.size(); ++j)
+                {
+                    std::shared_ptr<ThreadPool> executor = node_pool(partitions[jobs[j].partition].node);
+
+                    if (executor)
+                    {
+                        executor->submit([run, j]()
+                        {
+                            run(j);
+                        });
+                    }
+                }
+            }
+
+            // Claims from the back, while the workers take their queues from the front.
+            for (size_t j = jobs.size(); j-- > 0;)
+            {
+                run(j);
+            }
+
+            {
+                std::unique_lock<std::mutex> lock(state->mutex);
+                state->done.wait(lock, [&state]()
+                {
+                    return state->remaining == 0;
+                });
+            }
+
+            if (state->error)
+            {
+                std::rethrow_exception(state->error);
+            }
+
+            tT result = 0;
+
+            for (const tT &partial : state->partials)
+            {
+                result += partial;
+            }
+
+            return result;
+        }
+    }
+
+    /**
+     * Vector whose storage is split in contiguous partitions, each bound to one NUMA node. Two vectors created with the
+     * same size and nodes have identical partitions, so element-wise kernels only ever touch node-local memory.
+     */
+    template<typename tT>
+    class PartitionedVec
+    {
+    public:
+
+        using value_type = tT;
+
+        PartitionedVec(size_t size, const ::lineal::fill &fill = ::lineal::fill::none, std::vector<size_t> nodes = {})
+            : m_size(size)
+        {
+            const size_t available = impl::numa_topology().nodes();
+
+            if (nodes.empty())
+            {
+                for (size_t node = 0; node < available; ++node)
+                {
+                    nodes.push_back(node);
+                }
+            }
+
+            for (size_t node : nodes)
+            {
+                if (node >= available)
+                {
+                    throw std::out_of_range("PartitionedVec: NUMA node does not exist on this system");
+                }
+            }
+
+            // Partitions start on page boundaries, so no page is shared between two nodes.
+            constexpr size_t page = 4096 / sizeof(tT) > 0 ? 4096 / sizeof(tT) : 1;
+            const size_t per_node = (size / nodes.size() + page - 1) / page * page;
+
+            for (size_t i = 0, offset = 0; i < nodes.size() && offset < size; ++i, offset += per_node)
+            {
+                const size_t length = std::min(per_node, size - offset);
+                tT *data = nullptr;
+
+                try
+                {
+                    data = impl::NumaAllocator<tT>::allocate(length, nodes[i]);
+                }
+                catch (...)
+                {
+                    release();
+                    throw;
+                }
+
+                switch (fill)
+                {
+                case ::lineal::fill::ones:
+                    std::fill_n(data, length, 1);
+                    break;
+
+                case ::lineal::fill::zeros:
+                    std::fill_n(data, length, 0);
+                    break;
+
+                default:
+                    break;
+                }
+
+                m_partitions.push_back(impl::Partition<tT> {data, offset, length, nodes[i]});
+            }
+        }
+
+        PartitionedVec(const PartitionedVec &) = delete;
+
+        ~PartitionedVec()
+        {
+            release();
+        }
+
+        tT &operator[](const size_t i)
+        {
+            const impl::Partition<tT> &partition = m_partitions[locate(i)];
+            return partition.data[i - partition.offset];
+        }
+
+        const tT &operator[](const size_t i) const
+        {
+            const impl::Partition<tT> &partition = m_partitions[locate(i)];
+            return partition.data[i - partition.offset];
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        const std::vector<impl::Partition<tT>> &partitions() const
+        {
+            return m_partitions;
+        }
+
+    private:
+
+        size_t m_size;
+        std::vector<impl::Partition<tT>> m_partitions;
+
+        void release()
+        {
+            for (auto &partition : m_partitions)
+            {
+                impl::NumaAllocator<tT>::free(partition.data, partition.size);
+            }
+        }
+
+        size_t locate(size_t i) const
+        {
+            LINEAL_ASSERT(i < m_size, "PartitionedVec index out of range");
+            return std::min(i / m_partitions[0].size, m_partitions.size() - 1);
+        }
+    };
+
+    template<typename tT>
+    class PartitionedRow : public PartitionedVec<tT>
+    {
+    public:
+
+        using tParent = PartitionedVec<tT>;
+
+        using tParent::tParent;
+
+        PartitionedRow(const PartitionedRow &) = delete;
+    };
+
+    template<typename tT>
+    class PartitionedCol : public PartitionedVec<tT>
+    {
+    public:
+
+        using tParent = PartitionedVec<tT>;
+
+        using tParent::tParent;
+
+        PartitionedCol(const PartitionedCol &) = delete;
+    };
+
+    namespace impl
+    {
+        // Element-wise kernels pair partitions by index, so both vectors must be split at the same offsets.
+        template<typename tT>
+        bool same_partitions(const PartitionedVec<tT> &a, const PartitionedVec<tT> &b)
+        {
+            const auto &lhs = a.partitions();
+            const auto &rhs = b.partitions();
+
+            if (a.size() != b.size() || lhs.size() != rhs.size())
+            {
+                return false;
+            }
+
+            for (size_t p = 0; p < lhs.size(); ++p)
+            {
+                if (lhs[p].offset != rhs[p].offset || lhs[p].size != rhs[p].size)
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        template<typename tT>
+        tT partitioned_sum(const PartitionedVec<tT> &v)
+        {
+            const auto &partitions = v.partitions();
+
+            return partitioned_reduce<tT>(partitions, [&partitions](size_t p, size_t begin, size_t end)
+            {
+                ConstCol<tT> segment(partitions[p].data, partitions[p].size);
+                return sum_range(segment, begin, end);
+            });
+        }
+    }
+
+    template<typename tT>
+    tT sum(const PartitionedRow<tT> &v)
+    {
+        return impl::partitioned_sum(v);
+    }
+
+    template<typename tT>
+    tT sum(const PartitionedCol<tT> &v)
+    {
+        return impl::partitioned_sum(v);
+    }
+}
+
+template<typename tT>
+tT operator*(const ::lineal::PartitionedRow<tT> &row, const ::lineal::PartitionedCol<tT> &col)
+{
+    if (!::lineal::impl::same_partitions<tT>(row, col))
+    {
+        throw std::invalid_argument("PartitionedRow * PartitionedCol: vectors must have the same size and partitions");
+    }
+
+    const auto &rows = row.partitions();
+    const auto &cols = col.partitions();
+
+    return ::lineal::impl::partitioned_reduce<tT>(rows, [&rows, &cols](size_t p, size_t begin, size_t end)
+    {
+        ::lineal::ConstRow<tT> row_segment(rows[p].data, rows[p].size);
+        ::lineal::ConstCol<tT> col_segment(cols[p].data, cols[p].size);
+        return ::lineal::impl::inprod_range(row_segment, col_segment, begin, end);
+    });
+}
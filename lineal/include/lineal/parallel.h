@@ -0,0 +1,469 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/simd.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   include <windows.h>
+#elif defined(__linux__)
+#   include <pthread.h>
+#   include <sched.h>
+#endif
+
+// Vectors shorter than this (in elements) are always evaluated on the calling thread.
+#ifndef LINEAL_PARALLEL_THRESHOLD
+#define LINEAL_PARALLEL_THRESHOLD 262144
+#endif
+
+// Size in bytes of a single unit of work, chosen to fit comfortably in L2.
+#ifndef LINEAL_PARALLEL_CHUNK_BYTES
+#define LINEAL_PARALLEL_CHUNK_BYTES 131072
+#endif
+
+namespace lineal
+{
+    namespace impl
+    {
+        class ThreadPool;
+
+        struct WorkerIdentity
+        {
+            ThreadPool *pool = nullptr;
+            size_t index = 0;
+        };
+
+        inline WorkerIdentity &current_worker()
+        {
+            thread_local WorkerIdentity identity;
+            return identity;
+        }
+
+        /**
+         * Work-stealing pool. Every worker owns a deque; it pops its own work LIFO and steals FIFO from the others.
+         * Threads waiting on a result help out by executing pending tasks, so nested parallel calls cannot deadlock.
+         */
+        class ThreadPool
+        {
+        public:
+
+            using tTask = std::function<void()>;
+
+            ThreadPool(size_t threads, const std::vector<int> &cpus = {})
+                : m_pending(0),
+                  m_next(0),
+                  m_stop(false)
+            {
+                for (size_t i = 0; i < threads; ++i)
+                {
+                    m_queues.emplace_back(std::make_unique<Queue>());
+                }
+
+                for (size_t i = 0; i < threads; ++i)
+                {
+                    m_threads.emplace_back(&ThreadPool::work, this, i);
+
+                    if (!cpus.empty())
+                    {
+                        pin(m_threads.back(), cpus[i % cpus.size()]);
+                    }
+                }
+            }
+
+            ThreadPool(const ThreadPool &) = delete;
+
+            ~ThreadPool()
+            {
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_stop = true;
+                }
+
+                m_wake.notify_all();
+
+                for (auto &thread : m_threads)
+                {
+                    thread.join();
+                }
+            }
+
+            size_t size() const
+            {
+                return m_threads.size();
+            }
+
+            void submit(tTask task)
+            {
+                const WorkerIdentity &self = current_worker();
+                const size_t index = self.pool == this ? self.index : m_next.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+
+                {
+                    std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+                    m_queues[index]->tasks.emplace_back(std::move(task));
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    m_pending.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                m_wake.notify_one();
+            }
+
+            bool run_one()
+            {
+                const WorkerIdentity &self = current_worker();
+                const size_t index = self.pool == this ? self.index : m_next.load(std::memory_order_relaxed) % m_queues.size();
+
+                tTask task;
+
+                if ((self.pool == this && pop(index, task)) || steal(index, task))
+                {
+                    task();
+                    return true;
+                }
+
+                return false;
+            }
+
+            void wait(const std::atomic<size_t> &remaining)
+            {
+                while (remaining.load(std::memory_order_acquire) != 0)
+                {
+                    if (!run_one())
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            }
+
+        private:
+
+            struct Queue
+            {
+                std::mutex mutex;
+                std::deque<tTask> tasks;
+            };
+
+            std::vector<std::unique_ptr<Queue>> m_queues;
+            std::vector<std::thread> m_threads;
+            std::mutex m_mutex;
+            std::condition_variable m_wake;
+            std::atomic<size_t> m_pending;
+            std::atomic<size_t> m_next;
+            bool m_stop;
+
+            void work(size_t index)
+            {
+                current_worker() = WorkerIdentity{this, index};
+
+                tTask task;
+
+                while (true)
+                {
+                    if (pop(index, task) || steal(index, task))
+                    {
+                        task();
+                        continue;
+                    }
+
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_wake.wait(lock, [this]()
+                    {
+                        return m_stop || m_pending.load(std::memory_order_relaxed) != 0;
+                    });
+
+                    if (m_stop && m_pending.load(std::memory_order_relaxed) == 0)
+                    {
+                        return;
+                    }
+                }
+            }
+
+            bool pop(size_t index, tTask &task)
+            {
+                Queue &queue = *m_queues[index];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+
+                if (queue.tasks.empty())
+                {
+                    return false;
+                }
+
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+
+            bool steal(size_t thief, tTask &task)
+            {
+                for (size_t offset = 1, end = m_queues.size(); offset <= end; ++offset)
+                {
+                    Queue &queue = *m_queues[(thief + offset) % end];
+                    std::lock_guard<std::mutex> lock(queue.mutex);
+
+                    if (!queue.tasks.empty())
+                    {
+                        task = std::move(queue.tasks.front());
+                        queue.tasks.pop_front();
+                        m_pending.fetch_sub(1, std::memory_order_relaxed);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            static void pin(std::thread &thread, int cpu)
+            {
+#if defined(_WIN32)
+                SetThreadAffinityMask(thread.native_handle(), DWORD_PTR(1) << cpu);
+#elif defined(__linux__)
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                CPU_SET(cpu, &set);
+                pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &set);
+#else
+                (void)thread;
+                (void)cpu;
+#endif
+            }
+        };
+
+        // The last handle may be dropped by one of the pool's own workers, which cannot join itself.
+        inline std::shared_ptr<ThreadPool> make_pool(size_t threads, const std::vector<int> &cpus = {})
+        {
+            return std::shared_ptr<ThreadPool>(new ThreadPool(threads, cpus), [](ThreadPool *pool)
+            {
+                if (current_worker().pool == pool)
+                {
+                    std::thread([pool]()
+                    {
+                        delete pool;
+                    }).detach();
+                }
+                else
+                {
+                    delete pool;
+                }
+            });
+        }
+
+        struct ParallelState
+        {
+            std::mutex mutex;
+            std::shared_ptr<ThreadPool> pool;
+            // Read without the mutex on the fast path of pool(); written under it.
+            std::atomic<size_t> threads{std::max<size_t>(std::thread::hardware_concurrency(), 1)};
+            std::vector<int> cpus;
+            std::atomic<size_t> threshold{LINEAL_PARALLEL_THRESHOLD};
+        };
+
+        inline ParallelState &parallel_state()
+        {
+            static ParallelState state;
+            return state;
+        }
+
+        // Handles keep their pool alive, so reconfiguring never destroys a pool that is still in use.
+        inline std::shared_ptr<ThreadPool> pool()
+        {
+            ParallelState &state = parallel_state();
+            std::shared_ptr<ThreadPool> pool = std::atomic_load_explicit(&state.pool, std::memory_order_acquire);
+
+            if (!pool && state.threads.load(std::memory_order_relaxed) > 1)
+            {
+                std::lock_guard<std::mutex> lock(state.mutex);
+                pool = std::atomic_load_explicit(&state.pool, std::memory_order_relaxed);
+
+                if (!pool)
+                {
+                    // The calling thread takes part in every parallel loop, so it needs one worker less.
+                    pool = make_pool(state.threads.load(std::memory_order_relaxed) - 1, state.cpus);
+                    std::atomic_store_explicit(&state.pool, pool, std::memory_order_release);
+                }
+            }
+
+            return pool;
+        }
+
+        // The old pool finishes its pending tasks once the last handle to it is gone.
+        inline void reset_pool()
+        {
+            std::atomic_store_explicit(&parallel_state().pool, std::shared_ptr<ThreadPool>(), std::memory_order_release);
+        }
+
+        template<typename tT>
+        constexpr size_t chunk_size()
+        {
+            constexpr size_t count = PackedTypeHelper<tT>::count;
+            constexpr size_t elements = LINEAL_PARALLEL_CHUNK_BYTES / sizeof(tT);
+
+            return std::max<size_t>(elements - elements % count, count);
+        }
+
+        inline bool use_parallel(size_t count, size_t grain)
+        {
+            return count >= parallel_state().threshold.load(std::memory_order_relaxed) && count > grain;
+        }
+
+        template<typename tFunc>
+        void run_chunks(ThreadPool &executor, size_t chunks, const tFunc &func)
+        {
+            std::atomic<size_t> remaining(chunks - 1);
+            std::exception_ptr error;
+            std::mutex error_mutex;
+
+            auto run = [&](size_t chunk)
+            {
+                try
+                {
+                    func(chunk);
+                }
+                catch (...)
+                {
+                    std::lock_guard<std::mutex> lock(error_mutex);
+                    error = error ? error : std::current_exception();
+                }
+            };
+
+            for (size_t chunk = 1; chunk < chunks; ++chunk)
+            {
+                executor.submit([&run, &remaining, chunk]()
+                {
+                    run(chunk);
+                    remaining.fetch_sub(1, std::memory_order_release);
+                });
+            }
+
+            run(0);
+            executor.wait(remaining);
+
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        template<typename tFunc>
+        void parallel_for(size_t count, size_t grain, const tFunc &func)
+        {
+            std::shared_ptr<ThreadPool> executor = use_parallel(count, grain) ? pool() : nullptr;
+
+            if (!executor)
+            {
+                func(size_t(0), count);
+                return;
+            }
+
+            run_chunks(*executor, (count + grain - 1) / grain, [&](size_t chunk)
+            {
+                func(chunk * grain, std::min(count, (chunk + 1) * grain));
+            });
+        }
+
+        /**
+         * Splits [0, count) in chunks of `grain` elements, maps each chunk to a partial result and combines the partials
+         * in chunk order, so the result does not depend on the scheduling.
+         */
+        template<typename tT, typename tMap, typename tCombine>
+        tT parallel_reduce(size_t count, size_t grain, const tMap &map, const tCombine &combine)
+        {
+            std::shared_ptr<ThreadPool> executor = use_parallel(count, grain) ? pool() : nullptr;
+
+            if (!executor)
+            {
+                return map(size_t(0), count);
+            }
+
+            const size_t chunks = (count + grain - 1) / grain;
+            std::vector<tT> partials(chunks);
+
+            run_chunks(*executor, chunks, [&](size_t chunk)
+            {
+                partials[chunk] = map(chunk * grain, std::min(count, (chunk + 1) * grain));
+            });
+
+            tT result = partials[0];
+
+            for (size_t chunk = 1; chunk < chunks; ++chunk)
+            {
+                result = combine(result, partials[chunk]);
+            }
+
+            return result;
+        }
+    }
+
+    inline void set_num_threads(size_t threads)
+    {
+        impl::ParallelState &state = impl::parallel_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.threads.store(std::max<size_t>(threads, 1), std::memory_order_relaxed);
+        impl::reset_pool();
+    }
+
+    inline size_t get_num_threads()
+    {
+        return impl::parallel_state().threads.load(std::memory_order_relaxed);
+    }
+
+    // Pins worker i to cpus[i % cpus.size()]; an empty list leaves scheduling to the OS.
+    inline void set_thread_affinity(const std::vector<int> &cpus)
+    {
+        impl::ParallelState &state = impl::parallel_state();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.cpus = cpus;
+        impl::reset_pool();
+    }
+
+    inline void set_parallel_threshold(size_t elements)
+    {
+        impl::parallel_state().threshold.store(elements, std::memory_order_relaxed);
+    }
+
+    inline size_t get_parallel_threshold()
+    {
+        return impl::parallel_state().threshold.load(std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,142 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/eval.h"
+#include "lineal/vec.h"
+#include "lineal/vec_vec_op.h"
+
+#include <cstdint>
+
+/**
+ * Kernels compiled once into the lineal library (lineal/src/lineal.cpp) for the common element types: sums, inner
+ * products and the assignment loops of single scalar operations and multiply-adds on rows and columns. Clients built
+ * with LINEAL_PRECOMPILED, which the zpm export sets, declare them `extern template` and link the optimised object
+ * code instead of instantiating and optimising them again in every translation unit.
+ */
+#define LINEAL_SUM_KERNELS(prefix, tT)                                                                          \
+    prefix tT sum(const Row<tT> &, const MemoryPolicy &);                                                       \
+    prefix tT sum(const Col<tT> &, const MemoryPolicy &);                                                       \
+    prefix tT impl::sum_range(const Row<tT> &, size_t, size_t, const KernelConfig &);                           \
+    prefix tT impl::sum_range(const Col<tT> &, size_t, size_t, const KernelConfig &);
+
+#define LINEAL_INPROD_KERNELS(prefix, tT)                                                                       \
+    prefix tT impl::inprod_range(const Row<tT> &, const Col<tT> &, size_t, size_t, const KernelConfig &, bool); \
+    prefix tT impl::inprod_packed_range(const Row<tT> &, const Col<tT> &, size_t, size_t, const KernelConfig &);
+
+#define LINEAL_ADDITIVE_KERNELS(prefix, tVec, tT)                                                               \
+    prefix void impl::assign(tT *, const operations::VecPlusScalar<tVec<tT>, tT> &, size_t, const MemoryPolicy &); \
+    prefix void impl::assign(tT *, const operations::VecMinusScalar<tVec<tT>, tT> &, size_t, const MemoryPolicy &);
+
+#define LINEAL_MULTIPLICATIVE_KERNELS(prefix, tVec, tT)                                                         \
+    LINEAL_ADDITIVE_KERNELS(prefix, tVec, tT)                                                                   \
+    prefix void impl::assign(tT *, const operations::VecTimesScalar<tVec<tT>, tT> &, size_t, const MemoryPolicy &); \
+    prefix void impl::assign(tT *, const operations::VecDivScalar<tVec<tT>, tT> &, size_t, const MemoryPolicy &); \
+    prefix void impl::assign(tT *, const operations::VecFMA<tVec<tT>, tT, tT> &, size_t, const MemoryPolicy &);
+
+#define LINEAL_PRECOMPILED_KERNELS(prefix)                                                                      \
+    LINEAL_SUM_KERNELS(prefix, double)                                                                          \
+    LINEAL_SUM_KERNELS(prefix, float)                                                                           \
+    LINEAL_SUM_KERNELS(prefix, int32_t)                                                                         \
+    LINEAL_INPROD_KERNELS(prefix, double)                                                                       \
+    LINEAL_INPROD_KERNELS(prefix, float)                                                                        \
+    LINEAL_MULTIPLICATIVE_KERNELS(prefix, Row, double)                                                          \
+    LINEAL_MULTIPLICATIVE_KERNELS(prefix, Col, double)                                                          \
+    LINEAL_MULTIPLICATIVE_KERNELS(prefix, Row, float)                                                           \
+    LINEAL_MULTIPLICATIVE_KERNELS(prefix, Col, float)                                                           \
+    LINEAL_ADDITIVE_KERNELS(prefix, Row, int32_t)                                                               \
+    LINEAL_ADDITIVE_KERNELS(prefix, Col, int32_t)
+
+#if defined(LINEAL_PAD_STORAGE)
+#   define LINEAL_CONFIG_PAD_STORAGE 1
+#else
+#   define LINEAL_CONFIG_PAD_STORAGE 0
+#endif
+
+#if defined(LINEAL_ENABLE_COUNTERS)
+#   define LINEAL_CONFIG_COUNTERS 1
+#else
+#   define LINEAL_CONFIG_COUNTERS 0
+#endif
+
+#if defined(LINEAL_ENABLE_TRACING)
+#   define LINEAL_CONFIG_TRACING 1
+#else
+#   define LINEAL_CONFIG_TRACING 0
+#endif
+
+#if defined(LINEAL_COPY_ON_WRITE)
+#   define LINEAL_CONFIG_COPY_ON_WRITE 1
+#else
+#   define LINEAL_CONFIG_COPY_ON_WRITE 0
+#endif
+
+#define LINEAL_CONFIG_STRINGIZE_(x) #x
+#define LINEAL_CONFIG_STRINGIZE(x) LINEAL_CONFIG_STRINGIZE_(x)
+
+namespace lineal
+{
+    namespace impl
+    {
+        /**
+         * The library defines `value` only for the configuration it was built with, and every precompiled client refers
+         * to it. The settings are part of the symbol name, so a client whose storage layout or instrumentation differs
+         * from the library's fails to link instead of silently sharing mismatched kernels.
+         */
+        template<size_t tSmallBufferBytes, bool tPadStorage, bool tCounters, bool tTracing, bool tCopyOnWrite>
+        struct ConfigCheck
+        {
+            static const int value;
+        };
+
+        using BuildConfig = ConfigCheck<LINEAL_SMALL_BUFFER_BYTES, LINEAL_CONFIG_PAD_STORAGE, LINEAL_CONFIG_COUNTERS,
+                                        LINEAL_CONFIG_TRACING, LINEAL_CONFIG_COPY_ON_WRITE>;
+    }
+}
+
+#if defined(LINEAL_PRECOMPILED) || defined(LINEAL_BUILDING_LIBRARY)
+#   if defined(_MSC_VER)
+#       pragma detect_mismatch("lineal_config", "small_buffer=" LINEAL_CONFIG_STRINGIZE(LINEAL_SMALL_BUFFER_BYTES)  \
+                               " pad=" LINEAL_CONFIG_STRINGIZE(LINEAL_CONFIG_PAD_STORAGE)                           \
+                               " counters=" LINEAL_CONFIG_STRINGIZE(LINEAL_CONFIG_COUNTERS)                         \
+                               " tracing=" LINEAL_CONFIG_STRINGIZE(LINEAL_CONFIG_TRACING)                           \
+                               " cow=" LINEAL_CONFIG_STRINGIZE(LINEAL_CONFIG_COPY_ON_WRITE))
+#   endif
+#endif
+
+#if defined(LINEAL_PRECOMPILED) && !defined(LINEAL_BUILDING_LIBRARY)
+namespace lineal
+{
+    LINEAL_PRECOMPILED_KERNELS(extern template)
+
+#   if defined(__GNUC__)
+    namespace impl
+    {
+        // Kept in every object file, so the reference to the library's configuration symbol always reaches the linker.
+        [[gnu::used]] static const int *const config_check = &BuildConfig::value;
+    }
+#   endif
+}
+#endif
@@ -0,0 +1,211 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/counters.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Smallest block the scratch arena requests from the system.
+#ifndef LINEAL_SCRATCH_BLOCK_BYTES
+#define LINEAL_SCRATCH_BLOCK_BYTES 1048576
+#endif
+
+namespace lineal
+{
+    namespace impl
+    {
+        /**
+         * Per-thread bump allocator for the temporaries of a single evaluation. Deallocation is a no-op; the whole arena
+         * is rewound when the outermost ScratchScope on the thread closes. When an evaluation spilled into several
+         * blocks, they are merged into one on reset, so a steady workload settles on a single block and no allocations.
+         */
+        class ScratchArena
+            : public std::pmr::memory_resource
+        {
+        public:
+
+            ScratchArena() = default;
+            ScratchArena(const ScratchArena &) = delete;
+
+            ~ScratchArena()
+            {
+                release();
+            }
+
+            void enter()
+            {
+                ++m_depth;
+            }
+
+            void leave()
+            {
+                if (--m_depth == 0)
+                {
+                    reset();
+                }
+            }
+
+            size_t depth() const
+            {
+                return m_depth;
+            }
+
+            size_t blocks() const
+            {
+                return m_blocks.size();
+            }
+
+        protected:
+
+            void *do_allocate(size_t bytes, size_t alignment) override
+            {
+                if (!m_blocks.empty())
+                {
+                    if (void *ptr = bump(m_blocks.back(), bytes, alignment))
+                    {
+                        return ptr;
+                    }
+                }
+
+                grow(std::max<size_t>(bytes + alignment, LINEAL_SCRATCH_BLOCK_BYTES));
+                return bump(m_blocks.back(), bytes, alignment);
+            }
+
+            void do_deallocate(void *, size_t, size_t) override
+            {
+            }
+
+            bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+            {
+                return this == &other;
+            }
+
+        private:
+
+            static constexpr size_t block_alignment = 64;
+
+            struct Block
+            {
+                char *data;
+                size_t size;
+            };
+
+            void *bump(const Block &block, size_t bytes, size_t alignment)
+            {
+                const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(block.data);
+                const std::uintptr_t first = (base + m_offset + alignment - 1) / alignment * alignment;
+
+                if (first + bytes > base + block.size)
+                {
+                    return nullptr;
+                }
+
+                m_offset = first + bytes - base;
+                return reinterpret_cast<void *>(first);
+            }
+
+            void grow(size_t bytes)
+            {
+                LINEAL_COUNT(allocations, 1);
+                LINEAL_COUNT(allocated_bytes, bytes);
+
+                m_blocks.push_back(Block{static_cast<char *>(::operator new(bytes, std::align_val_t(block_alignment))), bytes});
+                m_offset = 0;
+            }
+
+            void reset()
+            {
+                if (m_blocks.size() > 1)
+                {
+                    size_t total = 0;
+
+                    for (const Block &block : m_blocks)
+                    {
+                        total += block.size;
+                    }
+
+                    release();
+                    grow(total);
+                }
+
+                m_offset = 0;
+            }
+
+            void release()
+            {
+                for (const Block &block : m_blocks)
+                {
+                    LINEAL_COUNT(frees, 1);
+                    ::operator delete(block.data, std::align_val_t(block_alignment));
+                }
+
+                m_blocks.clear();
+            }
+
+            std::vector<Block> m_blocks;
+            size_t m_offset = 0;
+            size_t m_depth = 0;
+        };
+
+        inline ScratchArena &scratch_arena()
+        {
+            thread_local ScratchArena arena;
+            return arena;
+        }
+
+        // Marks an evaluation that places temporaries in the scratch arena of the calling thread.
+        class ScratchScope
+        {
+        public:
+
+            ScratchScope()
+                : m_arena(scratch_arena())
+            {
+                m_arena.enter();
+            }
+
+            ScratchScope(const ScratchScope &) = delete;
+
+            ~ScratchScope()
+            {
+                m_arena.leave();
+            }
+
+            std::pmr::memory_resource *resource() const
+            {
+                return &m_arena;
+            }
+
+        private:
+
+            ScratchArena &m_arena;
+        };
+    }
+}
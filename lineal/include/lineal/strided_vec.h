@@ -0,0 +1,182 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/types.h"
+
+namespace lineal
+{
+    template<typename>
+    class StridedRow;
+    template<typename>
+    class StridedCol;
+
+    namespace impl
+    {
+        // Number of elements in [begin, end) taking every `step`-th one, for a view into a vector of `size` elements.
+        inline size_t subvec_count(size_t size, size_t begin, size_t end, size_t step = 1)
+        {
+            LINEAL_ASSERT(step != 0, "subvec step must be positive");
+            LINEAL_ASSERT(begin <= end && end <= size, "subvec range out of bounds");
+
+            return (end - begin + step - 1) / step;
+        }
+    }
+
+    /**
+     * Non-owning view over every `stride`-th element of existing storage, such as a row of a column-major block.
+     */
+    template<typename tT>
+    class StridedVec
+    {
+    public:
+
+        using value_type = tT;
+
+        StridedVec(const tT *auxiliary, size_t size, size_t stride)
+            : m_raw(auxiliary),
+              m_size(size),
+              m_stride(stride)
+        {
+        }
+
+        StridedVec(const StridedVec &) = delete;
+
+        const tT &operator[](const size_t i) const
+        {
+            return m_raw[i * m_stride];
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        size_t stride() const
+        {
+            return m_stride;
+        }
+
+        const tT *data() const
+        {
+            return m_raw;
+        }
+
+    private:
+
+        const tT *m_raw;
+        const size_t m_size;
+        const size_t m_stride;
+    };
+
+    template<typename tT>
+    class StridedCol : public StridedVec<tT>
+    {
+    public:
+
+        using tParent = StridedVec<tT>;
+
+        using tParent::tParent;
+
+        StridedCol(const StridedCol &) = delete;
+
+        StridedRow<tT> t() const
+        {
+            return StridedRow<tT>(this->data(), this->size(), this->stride());
+        }
+
+        StridedCol subvec(size_t begin, size_t end, size_t step = 1) const
+        {
+            return StridedCol(this->data() + begin * this->stride(), impl::subvec_count(this->size(), begin, end, step), this->stride() * step);
+        }
+    };
+
+    template<typename tT>
+    class StridedRow : public StridedVec<tT>
+    {
+    public:
+
+        using tParent = StridedVec<tT>;
+
+        using tParent::tParent;
+
+        StridedRow(const StridedRow &) = delete;
+
+        StridedCol<tT> t() const
+        {
+            return StridedCol<tT>(this->data(), this->size(), this->stride());
+        }
+
+        StridedRow subvec(size_t begin, size_t end, size_t step = 1) const
+        {
+            return StridedRow(this->data() + begin * this->stride(), impl::subvec_count(this->size(), begin, end, step), this->stride() * step);
+        }
+    };
+
+    template<Orientation tOrient, typename tT>
+    struct VecOrientationHelper<tOrient, StridedRow<tT>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationRow;
+        }
+    };
+
+    template<Orientation tOrient, typename tT>
+    struct VecOrientationHelper<tOrient, StridedCol<tT>>
+    {
+        constexpr static bool check()
+        {
+            return tOrient == Orientation::OrientationCol;
+        }
+    };
+
+    template<typename tT>
+    constexpr bool is_raw_vec<StridedRow<tT>> = true;
+    template<typename tT>
+    constexpr bool is_raw_vec<StridedCol<tT>> = true;
+
+    template<typename tT>
+    constexpr bool is_strided_vec<StridedRow<tT>> = true;
+    template<typename tT>
+    constexpr bool is_strided_vec<StridedCol<tT>> = true;
+
+    namespace impl
+    {
+        // Distance between consecutive elements of a leaf vector, as passed to BLAS.
+        template<typename tVec>
+        size_t stride_of(const tVec &v)
+        {
+            if constexpr(is_strided_vec<tVec>)
+            {
+                return v.stride();
+            }
+            else
+            {
+                return 1;
+            }
+        }
+    }
+}
@@ -0,0 +1,363 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// With LINEAL_ENABLE_TRACING defined, LINEAL_TRACE records the latency of the enclosing scope; otherwise it compiles
+// to nothing.
+#if defined(LINEAL_ENABLE_TRACING)
+#define LINEAL_TRACE(op, size) ::lineal::impl::TraceScope lineal_trace_scope(::lineal::TraceOp::op, (size))
+#else
+#define LINEAL_TRACE(op, size) ((void)0)
+#endif
+
+namespace lineal
+{
+    enum class TraceOp
+    {
+        inprod,
+        inprod_expr,
+        sum,
+        assign,
+        fused,
+        batch,
+        count
+    };
+
+    inline const char *trace_op_name(TraceOp op)
+    {
+        constexpr const char *names[static_cast<size_t>(TraceOp::count)] =
+        {
+            "inprod",
+            "inprod_expr",
+            "sum",
+            "assign",
+            "fused",
+            "batch"
+        };
+
+        return names[static_cast<size_t>(op)];
+    }
+
+    namespace impl
+    {
+        /**
+         * Log-linear latency histogram in the style of HdrHistogram: one bucket group per power of two nanoseconds,
+         * each split into 16 linear sub-buckets, for a relative error below 1/16 from 1ns up to 2^44ns, about 4.9 hours.
+         */
+        class LatencyHistogram
+        {
+        public:
+
+            static constexpr size_t sub_bits = 4;
+            static constexpr size_t sub_count = size_t(1) << sub_bits;
+            static constexpr size_t magnitudes = 40;
+            static constexpr size_t bucket_count = (magnitudes + 1) * sub_count;
+
+            static size_t bucket_of(uint64_t ns)
+            {
+                if (ns < sub_count)
+                {
+                    return static_cast<size_t>(ns);
+                }
+
+                size_t magnitude = 0;
+
+                while ((ns >> magnitude) >= 2 * sub_count)
+                {
+                    ++magnitude;
+                }
+
+                const size_t bucket = (magnitude + 1) * sub_count + static_cast<size_t>((ns >> magnitude) - sub_count);
+                return std::min(bucket, bucket_count - 1);
+            }
+
+            // Upper bound of the latencies that fall into `bucket`.
+            static uint64_t value_of(size_t bucket)
+            {
+                if (bucket < sub_count)
+                {
+                    return bucket;
+                }
+
+                const size_t magnitude = bucket / sub_count - 1;
+                return ((uint64_t(bucket % sub_count) + sub_count + 1) << magnitude) - 1;
+            }
+
+            // Only the owning thread records, so a relaxed load and store is enough.
+            void record(uint64_t ns)
+            {
+                bump(m_buckets[bucket_of(ns)], 1);
+                bump(m_count, 1);
+                m_max.store(std::max(m_max.load(std::memory_order_relaxed), ns), std::memory_order_relaxed);
+            }
+
+            void merge_into(std::array<uint64_t, bucket_count> &buckets, uint64_t &count, uint64_t &max) const
+            {
+                for (size_t i = 0; i < bucket_count; ++i)
+                {
+                    buckets[i] += m_buckets[i].load(std::memory_order_relaxed);
+                }
+
+                count += m_count.load(std::memory_order_relaxed);
+                max = std::max(max, m_max.load(std::memory_order_relaxed));
+            }
+
+            void clear()
+            {
+                for (std::atomic<uint64_t> &bucket : m_buckets)
+                {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+
+                m_count.store(0, std::memory_order_relaxed);
+                m_max.store(0, std::memory_order_relaxed);
+            }
+
+        private:
+
+            static void bump(std::atomic<uint64_t> &value, uint64_t amount)
+            {
+                value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+            }
+
+            std::array<std::atomic<uint64_t>, bucket_count> m_buckets{};
+            std::atomic<uint64_t> m_count{0};
+            std::atomic<uint64_t> m_max{0};
+        };
+
+        // Calls are keyed by operation and by the power of two of their element count.
+        constexpr size_t trace_size_buckets = 48;
+
+        inline size_t size_bucket(size_t size)
+        {
+            size_t bucket = 0;
+
+            while (bucket + 1 < trace_size_buckets && (size >> (bucket + 1)) != 0)
+            {
+                ++bucket;
+            }
+
+            return bucket;
+        }
+
+        /**
+         * Histograms of one thread, created on first use and published with a release store so `dump_traces` can read
+         * them from another thread without locks on the recording path.
+         */
+        struct ThreadTraces
+        {
+            static constexpr size_t slot_count = static_cast<size_t>(TraceOp::count) * trace_size_buckets;
+
+            std::array<std::atomic<LatencyHistogram *>, slot_count> slots{};
+            std::vector<std::unique_ptr<LatencyHistogram>> owned;
+
+            ThreadTraces();
+            ~ThreadTraces();
+
+            void record(TraceOp op, size_t size, uint64_t ns)
+            {
+                std::atomic<LatencyHistogram *> &slot = slots[static_cast<size_t>(op) * trace_size_buckets + size_bucket(size)];
+                LatencyHistogram *histogram = slot.load(std::memory_order_relaxed);
+
+                if (!histogram)
+                {
+                    owned.push_back(std::make_unique<LatencyHistogram>());
+                    histogram = owned.back().get();
+                    slot.store(histogram, std::memory_order_release);
+                }
+
+                histogram->record(ns);
+            }
+        };
+
+        struct TraceTotals
+        {
+            std::array<uint64_t, LatencyHistogram::bucket_count> buckets{};
+            uint64_t count = 0;
+            uint64_t max = 0;
+        };
+
+        struct TraceRegistry
+        {
+            std::mutex mutex;
+            std::vector<ThreadTraces *> threads;
+            std::vector<TraceTotals> retired = std::vector<TraceTotals>(ThreadTraces::slot_count);
+        };
+
+        // Leaked on purpose: thread_local traces of detached workers can retire after static destructors have run.
+        inline TraceRegistry &trace_registry()
+        {
+            static TraceRegistry *registry = new TraceRegistry();
+            return *registry;
+        }
+
+        inline ThreadTraces::ThreadTraces()
+        {
+            TraceRegistry &registry = trace_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.threads.push_back(this);
+        }
+
+        inline ThreadTraces::~ThreadTraces()
+        {
+            TraceRegistry &registry = trace_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+
+            for (size_t i = 0; i < slot_count; ++i)
+            {
+                if (const LatencyHistogram *histogram = slots[i].load(std::memory_order_acquire))
+                {
+                    TraceTotals &totals = registry.retired[i];
+                    histogram->merge_into(totals.buckets, totals.count, totals.max);
+                }
+            }
+
+            registry.threads.erase(std::find(registry.threads.begin(), registry.threads.end(), this));
+        }
+
+        inline ThreadTraces &thread_traces()
+        {
+            thread_local ThreadTraces traces;
+            return traces;
+        }
+
+        class TraceScope
+        {
+        public:
+
+            TraceScope(TraceOp op, size_t size)
+                : m_op(op),
+                  m_size(size),
+                  m_start(std::chrono::steady_clock::now())
+            {
+            }
+
+            TraceScope(const TraceScope &) = delete;
+
+            ~TraceScope()
+            {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+                thread_traces().record(m_op, m_size, static_cast<uint64_t>(elapsed.count()));
+            }
+
+        private:
+
+            TraceOp m_op;
+            size_t m_size;
+            std::chrono::steady_clock::time_point m_start;
+        };
+
+        inline uint64_t percentile(const TraceTotals &totals, double fraction)
+        {
+            const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(fraction * totals.count + 0.5));
+            uint64_t seen = 0;
+
+            for (size_t i = 0; i < LatencyHistogram::bucket_count; ++i)
+            {
+                seen += totals.buckets[i];
+
+                if (seen >= rank)
+                {
+                    return std::min(LatencyHistogram::value_of(i), totals.max);
+                }
+            }
+
+            return totals.max;
+        }
+    }
+
+    /**
+     * Prints one line per operation and size bucket that has been traced, with the call count and the p50, p99, p999
+     * and maximum latency in nanoseconds, merged over all threads. Prints nothing unless LINEAL_ENABLE_TRACING is
+     * defined.
+     */
+    inline void dump_traces(std::ostream &out)
+    {
+        impl::TraceRegistry &registry = impl::trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        std::vector<impl::TraceTotals> totals = registry.retired;
+
+        for (const impl::ThreadTraces *traces : registry.threads)
+        {
+            for (size_t i = 0; i < impl::ThreadTraces::slot_count; ++i)
+            {
+                if (const impl::LatencyHistogram *histogram = traces->slots[i].load(std::memory_order_acquire))
+                {
+                    histogram->merge_into(totals[i].buckets, totals[i].count, totals[i].max);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < impl::ThreadTraces::slot_count; ++i)
+        {
+            if (totals[i].count == 0)
+            {
+                continue;
+            }
+
+            const TraceOp op = static_cast<TraceOp>(i / impl::trace_size_buckets);
+            const size_t bucket = i % impl::trace_size_buckets;
+
+            out << trace_op_name(op)
+                << " size=[" << (bucket == 0 ? 0 : size_t(1) << bucket) << "," << (size_t(1) << (bucket + 1)) << ")"
+                << " calls=" << totals[i].count
+                << " p50=" << impl::percentile(totals[i], 0.5)
+                << " p99=" << impl::percentile(totals[i], 0.99)
+                << " p999=" << impl::percentile(totals[i], 0.999)
+                << " max=" << totals[i].max << "ns\n";
+        }
+    }
+
+    // Clears all histograms; meant to be called between measurement phases, as calls recorded concurrently may be lost.
+    inline void reset_traces()
+    {
+        impl::TraceRegistry &registry = impl::trace_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        registry.retired.assign(impl::ThreadTraces::slot_count, impl::TraceTotals());
+
+        for (impl::ThreadTraces *traces : registry.threads)
+        {
+            for (std::atomic<impl::LatencyHistogram *> &slot : traces->slots)
+            {
+                if (impl::LatencyHistogram *histogram = slot.load(std::memory_order_acquire))
+                {
+                    histogram->clear();
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,178 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/vec_scalar_op.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/unary.h"
+#include "lineal/types.h"
+
+namespace lineal
+{
+    namespace operations
+    {
+        /**
+         * Expression node with the opposite orientation of its operand. It forwards every load, so it adds no work; raw
+         * vectors are transposed through `t()` views instead. It deliberately has no `tOperand`, so canonicalisation
+         * never looks through it and loses the flipped orientation. The operand is held by value, so async copies of
+         * the node keep their own copy of every nested temporary.
+         */
+        template<typename tOp>
+        struct Transpose
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            const tOp op;
+
+            using value_type = typename tOp::value_type;
+
+            Transpose(const tOp &o)
+                : op(o)
+            {}
+
+            value_type operator[](size_t i) const
+            {
+                return op[i];
+            }
+
+            size_t size() const
+            {
+                return op.size();
+            }
+
+        private:
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::prepare(op, s, m);
+            }
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load(op, i, v, s, m);
+            }
+        };
+    }
+
+    template<Orientation tOrient, typename tOp>
+    struct VecOrientationHelper<tOrient, operations::Transpose<tOp>>
+    {
+        constexpr static bool check()
+        {
+            if constexpr(tOrient == Orientation::OrientationRow)
+            {
+                return is_col<tOp>;
+            }
+            else
+            {
+                return is_row<tOp>;
+            }
+        }
+    };
+
+    namespace impl
+    {
+        template<typename tOp>
+        struct FixedSizeOf<operations::Transpose<tOp>>
+        {
+            static constexpr size_t value = fixed_size_of<tOp>;
+        };
+
+        template<typename tOp>
+        struct ComputeBound<operations::Transpose<tOp>> : ComputeBound<tOp>
+        {};
+    }
+
+    template<typename tVec, std::enable_if_t<is_raw_vec<tVec>, int> = 0>
+    auto t(const tVec &v)
+    {
+        return v.t();
+    }
+
+    template<typename tOp, std::enable_if_t<is_vec_op<tOp>, int> = 0>
+    auto t(const tOp &op)
+    {
+        return operations::Transpose<tOp>(op);
+    }
+
+    template<typename tOp>
+    tOp t(const operations::Transpose<tOp> &op)
+    {
+        return op.op;
+    }
+}
+
+// Scalar operations move inside the transposition, so the operand keeps its usual simplifications.
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator+(const ::lineal::operations::Transpose<tOp> &op, const tT &t)
+{
+    return ::lineal::t(op.op + t);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator+(const tT &t, const ::lineal::operations::Transpose<tOp> &op)
+{
+    return ::lineal::t(t + op.op);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const ::lineal::operations::Transpose<tOp> &op, const tT &t)
+{
+    return ::lineal::t(op.op - t);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const tT &t, const ::lineal::operations::Transpose<tOp> &op)
+{
+    return ::lineal::t(t - op.op);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator*(const ::lineal::operations::Transpose<tOp> &op, const tT &t)
+{
+    return ::lineal::t(op.op * t);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator*(const tT &t, const ::lineal::operations::Transpose<tOp> &op)
+{
+    return ::lineal::t(t * op.op);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const ::lineal::operations::Transpose<tOp> &op, const tT &t)
+{
+    return ::lineal::t(op.op / t);
+}
+
+template<typename tOp, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const tT &t, const ::lineal::operations::Transpose<tOp> &op)
+{
+    return ::lineal::t(t / op.op);
+}
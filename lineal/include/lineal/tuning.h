@@ -0,0 +1,432 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/simd.h"
+#include "lineal/types.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#   include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#   include <cpuid.h>
+#endif
+
+// Outputs larger than this many bytes are not expected to stay in the last level cache, and are written with
+// non-temporal stores.
+#ifndef LINEAL_STREAMING_THRESHOLD
+#define LINEAL_STREAMING_THRESHOLD 33554432
+#endif
+
+// Inner products of at least this many elements are handed to BLAS, unless a tuning file says otherwise.
+#ifndef LINEAL_BLAS_CROSSOVER
+#   define LINEAL_BLAS_CROSSOVER 1024
+#endif
+
+namespace lineal
+{
+    /**
+     * Shape of the reduction and inner product kernels. `unroll` packed registers are loaded per iteration, spread over
+     * `accumulators` independent sums; `prefetch_lines` cache lines ahead of the loads are prefetched (0 disables it).
+     * Inner products of at least `blas_crossover` doubles, or `blas_crossover_float` floats, are handed to BLAS.
+     * Only the combinations in `impl::kernel_variants` are compiled; others fall back to the default.
+     */
+    struct KernelConfig
+    {
+        size_t accumulators = 4;
+        size_t unroll = 4;
+        size_t prefetch_lines = 0;
+        size_t blas_crossover = LINEAL_BLAS_CROSSOVER;
+        size_t blas_crossover_float = LINEAL_BLAS_CROSSOVER;
+    };
+
+    // Identifies the CPU (vendor, family, model, stepping) and the SIMD width lineal was compiled for.
+    inline std::string cpu_signature()
+    {
+        unsigned int regs[4] = {0, 0, 0, 0};
+        char vendor[13] = {0};
+        bool known = false;
+
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        regs[1] = info[1], regs[2] = info[2], regs[3] = info[3];
+        std::memcpy(vendor, &regs[1], 4);
+        std::memcpy(vendor + 4, &regs[3], 4);
+        std::memcpy(vendor + 8, &regs[2], 4);
+        __cpuid(info, 1);
+        regs[0] = info[0];
+        known = true;
+#elif defined(__x86_64__) || defined(__i386__)
+        if (__get_cpuid(0, &regs[0], &regs[1], &regs[2], &regs[3]))
+        {
+            std::memcpy(vendor, &regs[1], 4);
+            std::memcpy(vendor + 4, &regs[3], 4);
+            std::memcpy(vendor + 8, &regs[2], 4);
+            known = __get_cpuid(1, &regs[0], &regs[1], &regs[2], &regs[3]);
+        }
+#endif
+
+        std::ostringstream signature;
+
+        if (known)
+        {
+            const unsigned int family = ((regs[0] >> 8) & 0xf) + ((regs[0] >> 20) & 0xff);
+            const unsigned int model = ((regs[0] >> 4) & 0xf) | ((regs[0] >> 12) & 0xf0);
+
+            signature << vendor << "-" << family << "-" << model << "-" << (regs[0] & 0xf);
+        }
+        else
+        {
+            signature << "generic";
+        }
+
+        signature << "-simd" << (simd::has_simd ? simd::register_bits : 0);
+        return signature.str();
+    }
+
+    namespace impl
+    {
+        struct KernelVariant
+        {
+            size_t accumulators;
+            size_t unroll;
+        };
+
+        constexpr KernelVariant kernel_variants[] = { {1, 1}, {1, 2}, {2, 2}, {2, 4}, {4, 4}, {4, 8}, {8, 8} };
+
+        template<typename tT>
+        size_t blas_crossover(const KernelConfig &config)
+        {
+            return std::is_same_v<tT, float> ? config.blas_crossover_float : config.blas_crossover;
+        }
+
+        // Reads the entry for this CPU from a tuning file, leaving `config` untouched when there is none. Entries
+        // written before the float crossover was tuned separately keep its default.
+        inline bool read_tuning(const std::string &path, const std::string &signature, KernelConfig &config)
+        {
+            std::ifstream in(path);
+            std::string line;
+
+            while (std::getline(in, line))
+            {
+                std::istringstream fields(line);
+                std::string key;
+                KernelConfig entry;
+
+                if (fields >> key >> entry.accumulators >> entry.unroll >> entry.prefetch_lines >> entry.blas_crossover &&
+                        key == signature)
+                {
+                    if (!(fields >> entry.blas_crossover_float))
+                    {
+                        entry.blas_crossover_float = LINEAL_BLAS_CROSSOVER;
+                    }
+
+                    config = entry;
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        inline KernelConfig &kernel_config_storage()
+        {
+            static KernelConfig config = []
+            {
+                KernelConfig initial;
+
+                if (const char *path = std::getenv("LINEAL_TUNING_FILE"))
+                {
+                    read_tuning(path, cpu_signature(), initial);
+                }
+
+                return initial;
+            }();
+
+            return config;
+        }
+    }
+
+    /**
+     * The kernel configuration in use. On first use it is loaded from the file named by the LINEAL_TUNING_FILE
+     * environment variable, when that file has an entry for this CPU.
+     */
+    inline const KernelConfig &kernel_config()
+    {
+        return impl::kernel_config_storage();
+    }
+
+    // Not synchronised with running kernels; meant to be called at startup.
+    inline void set_kernel_config(const KernelConfig &config)
+    {
+        impl::kernel_config_storage() = config;
+    }
+
+    /**
+     * How a kernel moves data for large inputs: loads are prefetched `prefetch_lines` cache lines ahead (0 disables
+     * it), and outputs of more than `streaming_threshold` bytes are written with non-temporal stores that bypass the
+     * cache. Taken by `assign`, `sum` and `inprod`.
+     */
+    struct MemoryPolicy
+    {
+        size_t prefetch_lines = 0;
+        size_t streaming_threshold = LINEAL_STREAMING_THRESHOLD;
+
+        // Plain loads and stores, whatever the size.
+        static MemoryPolicy cached()
+        {
+            return { 0, std::numeric_limits<size_t>::max() };
+        }
+
+        // Prefetches far enough ahead to cover DRAM latency and streams every output.
+        static MemoryPolicy streaming(size_t prefetch_lines = 16)
+        {
+            return { prefetch_lines, 0 };
+        }
+    };
+
+    // The policy kernels use when none is given: the tuned prefetch distance and LINEAL_STREAMING_THRESHOLD.
+    inline MemoryPolicy memory_policy()
+    {
+        return { kernel_config().prefetch_lines, LINEAL_STREAMING_THRESHOLD };
+    }
+
+    // `config` with the prefetch distance of `policy`.
+    inline KernelConfig with_policy(KernelConfig config, const MemoryPolicy &policy)
+    {
+        config.prefetch_lines = policy.prefetch_lines;
+        return config;
+    }
+
+    inline bool load_tuning(const std::string &path)
+    {
+        KernelConfig config = kernel_config();
+
+        if (!impl::read_tuning(path, cpu_signature(), config))
+        {
+            return false;
+        }
+
+        set_kernel_config(config);
+        return true;
+    }
+
+    // Stores `config` as the entry for this CPU, keeping the entries of other CPUs in the file.
+    inline bool save_tuning(const std::string &path, const KernelConfig &config)
+    {
+        const std::string signature = cpu_signature();
+        std::vector<std::string> lines;
+
+        {
+            std::ifstream in(path);
+            std::string line;
+
+            while (std::getline(in, line))
+            {
+                if (line.compare(0, signature.size() + 1, signature + " ") != 0)
+                {
+                    lines.push_back(line);
+                }
+            }
+        }
+
+        std::ofstream out(path);
+
+        for (const std::string &line : lines)
+        {
+            out << line << '\n';
+        }
+
+        out << signature << ' ' << config.accumulators << ' ' << config.unroll << ' ' << config.prefetch_lines << ' '
+            << config.blas_crossover << ' ' << config.blas_crossover_float << '\n';
+
+        return static_cast<bool>(out);
+    }
+
+    namespace impl
+    {
+        inline void prefetch(const void *address)
+        {
+#if defined(__GNUC__)
+            __builtin_prefetch(address, 0, 0);
+#elif defined(_MSC_VER)
+            _mm_prefetch(static_cast<const char *>(address), _MM_HINT_NTA);
+#else
+            (void)address;
+#endif
+        }
+
+        // Prefetches the cache lines `ahead` bytes past elements [i, i + tCount) of `stream`.
+        template<size_t tCount, typename tS>
+        void prefetch_ahead(const tS *stream, size_t i, size_t ahead)
+        {
+            const char *address = reinterpret_cast<const char *>(stream + i) + ahead;
+
+            for (size_t offset = 0; offset < tCount * sizeof(tS); offset += 64)
+            {
+                prefetch(address + offset);
+            }
+        }
+
+        template<size_t tAccumulators, size_t tUnroll, typename tT, typename tS0, typename tS1, typename tLoad>
+        PackedType<tT> reduce_packed_unrolled(size_t i, size_t end, size_t prefetch_lines, const tS0 *stream0,
+                                              const tS1 *stream1, tLoad &load)
+        {
+            constexpr size_t count = PackedTypeHelper<tT>::count;
+
+            tT init = 0;
+            PackedType<tT> acc[tAccumulators];
+
+            for (size_t a = 0; a < tAccumulators; ++a)
+            {
+                acc[a] = ::simdpp::load_splat(&init);
+            }
+
+            const size_t ahead = prefetch_lines * 64;
+
+            for (; i + tUnroll <= end; i += tUnroll)
+            {
+                if (ahead != 0)
+                {
+                    prefetch_ahead<tUnroll * count>(stream0, i * count, ahead);
+
+                    if (stream1)
+                    {
+                        prefetch_ahead<tUnroll * count>(stream1, i * count, ahead);
+                    }
+                }
+
+                for (size_t u = 0; u < tUnroll; ++u)
+                {
+                    acc[u % tAccumulators] = ::simdpp::add(acc[u % tAccumulators], load(i + u));
+                }
+            }
+
+            for (; i < end; ++i)
+            {
+                acc[0] = ::simdpp::add(acc[0], load(i));
+            }
+
+            for (size_t step = 1; step < tAccumulators; step *= 2)
+            {
+                for (size_t a = 0; a + step < tAccumulators; a += 2 * step)
+                {
+                    acc[a] = ::simdpp::add(acc[a], acc[a + step]);
+                }
+            }
+
+            return acc[0];
+        }
+
+        template<typename tT, size_t tVariant = 0, typename tS0, typename tS1, typename tLoad>
+        PackedType<tT> reduce_packed_variant(size_t i, size_t end, const KernelConfig &config, const tS0 *stream0,
+                                             const tS1 *stream1, tLoad &load)
+        {
+            constexpr KernelVariant variant = kernel_variants[tVariant];
+            constexpr size_t variants = sizeof(kernel_variants) / sizeof(KernelVariant);
+
+            if (variant.accumulators == config.accumulators && variant.unroll == config.unroll)
+            {
+                return reduce_packed_unrolled<variant.accumulators, variant.unroll, tT>(i, end, config.prefetch_lines,
+                        stream0, stream1, load);
+            }
+
+            if constexpr(tVariant + 1 < variants)
+            {
+                return reduce_packed_variant < tT, tVariant + 1 > (i, end, config, stream0, stream1, load);
+            }
+            else
+            {
+                return reduce_packed_unrolled<4, 4, tT>(i, end, config.prefetch_lines, stream0, stream1, load);
+            }
+        }
+
+        template<typename tOp, typename = void>
+        constexpr bool has_operand = false;
+
+        template<typename tOp>
+        constexpr bool has_operand<tOp, std::void_t<typename tOp::tOperand>> = true;
+
+        template<typename tOp, typename = void>
+        constexpr bool wraps_op = false;
+
+        template<typename tOp>
+        constexpr bool wraps_op<tOp, std::void_t<decltype(std::declval<const tOp &>().op)>> = true;
+
+        /**
+         * The contiguous array an expression streams its loads from, found by following the operands down to the
+         * innermost vector; nullptr when that vector is strided, as there is no sequential stream to prefetch.
+         */
+        template<typename tOp>
+        auto source_of(const tOp &v)
+        {
+            if constexpr(is_raw_vec<tOp> && !is_strided_vec<tOp>)
+            {
+                return v.data();
+            }
+            else if constexpr(!is_raw_vec<tOp> && has_operand<tOp>)
+            {
+                return source_of(v.vec);
+            }
+            else if constexpr(!is_raw_vec<tOp> && wraps_op<tOp>)
+            {
+                return source_of(v.op);
+            }
+            else
+            {
+                return static_cast<const typename tOp::value_type *>(nullptr);
+            }
+        }
+
+        /**
+         * Sums `load(i)` over the packed indices [`begin`, `end`) with the kernel shape of `config`. `stream0` and
+         * `stream1` are the arrays behind the loads, from `source_of`, used for prefetching; either may be nullptr.
+         */
+        template<typename tT, typename tS0, typename tS1, typename tLoad>
+        PackedType<tT> reduce_packed(size_t begin, size_t end, const KernelConfig &config, const tS0 *stream0,
+                                     const tS1 *stream1, tLoad &&load)
+        {
+            KernelConfig effective = config;
+
+            if (!stream0)
+            {
+                effective.prefetch_lines = 0;
+            }
+
+            return reduce_packed_variant<tT>(begin, end, effective, stream0, stream1, load);
+        }
+    }
+}
@@ -27,8 +27,14 @@
 #include "lineal/types.h"
 #include "lineal/simd.h"
 
+#include <cassert>
 #include <type_traits>
+#include <utility>
 
+// Precondition checks, compiled out with NDEBUG unless redefined.
+#ifndef LINEAL_ASSERT
+#define LINEAL_ASSERT(condition, message) assert((condition) && message)
+#endif
 
 namespace lineal
 {
@@ -93,6 +99,8 @@ namespace lineal
         struct VecScalarOp;
         template<typename, typename, typename>
         struct VecFMABase;
+        template<typename, typename>
+        struct VecMobiusBase;
     }
 
     template<typename... tTypes>
@@ -137,7 +145,8 @@ namespace lineal
     {
         constexpr static bool check()
         {
-            if constexpr(std::is_base_of_v<operations::VecScalarOp<tVec, tT>, tOp<tVec, tT>>)
+            if constexpr(std::is_base_of_v<operations::VecScalarOp<tVec, tT>, tOp<tVec, tT>> ||
+                         std::is_base_of_v<operations::VecMobiusBase<tVec, tT>, tOp<tVec, tT>>)
             {
                 return VecOrientationHelper<tOrient, tVec>::check();
             }
@@ -296,4 +305,47 @@ namespace lineal
 
     template<typename tVec>
     constexpr bool is_vec_op = is_vec<tVec> &&!is_raw_vec<tVec>;
+
+    template<typename>
+    constexpr bool is_fixed_vec = false;
+
+    template<typename>
+    constexpr bool is_strided_vec = false;
+
+    namespace impl
+    {
+        template<typename tVec, typename = void>
+        struct PaddedExtent
+        {
+            static size_t get(const tVec &v)
+            {
+                return v.size();
+            }
+        };
+
+        template<typename tVec>
+        struct PaddedExtent<tVec, std::void_t<decltype(std::declval<const tVec &>().capacity())>>
+        {
+            static size_t get(const tVec &v)
+            {
+                return v.capacity();
+            }
+        };
+
+        // Packed index to stop the register loop at. When the range ends at the end of the vectors and all of them
+        // own zeroed padding up to the next register, the last partial register is included and no scalar tail is left.
+        template<typename tT, typename... tVecs>
+        size_t packed_end(size_t size, size_t end, const tVecs &... vecs)
+        {
+            constexpr size_t count = PackedTypeHelper<tT>::count;
+            const size_t rounded = (end + count - 1) / count * count;
+
+            if (end == size && ((PaddedExtent<tVecs>::get(vecs) >= rounded) && ...))
+            {
+                return rounded / count;
+            }
+
+            return end / count;
+        }
+    }
 }
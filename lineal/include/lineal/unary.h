@@ -0,0 +1,368 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include "lineal/math.h"
+#include "lineal/vec_scalar_op.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/types.h"
+
+#include <cmath>
+#include <type_traits>
+
+namespace lineal
+{
+    namespace impl
+    {
+        /**
+         * Element functions of VecUnary. `apply` is the scalar path, used by `operator[]` and the tails of the packed
+         * loops; `packed` is the SIMD kernel from math.h. The two may differ in the last bits, within the error bound of
+         * the kernel. `supports` names the element types the function is defined for.
+         */
+        struct ExpFunc
+        {
+            static constexpr Cost cost = {0, 0, 32, 0, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return std::exp(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_exp<tT>(x);
+            }
+        };
+
+        struct LogFunc
+        {
+            static constexpr Cost cost = {0, 0, 32, 1, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return std::log(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_log<tT>(x);
+            }
+        };
+
+        // The square root is counted as a division: both go through the same long-latency unit.
+        struct SqrtFunc
+        {
+            static constexpr Cost cost = {0, 0, 1, 1, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return std::sqrt(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_sqrt<tT>(x);
+            }
+        };
+
+        struct RsqrtFunc
+        {
+            static constexpr Cost cost = {0, 0, 2, 2, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return tT(1) / std::sqrt(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_rsqrt<tT>(x);
+            }
+        };
+
+        struct TanhFunc
+        {
+            static constexpr Cost cost = {0, 0, 38, 1, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return std::tanh(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_tanh<tT>(x);
+            }
+        };
+
+        // Clears the sign bit of floats; signed integers go through the packed abs.
+        struct AbsFunc
+        {
+            static constexpr Cost cost = {0, 0, 1, 0, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_signed_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return std::abs(x);
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return ::simdpp::abs(x);
+            }
+        };
+
+        struct SigmoidFunc
+        {
+            static constexpr Cost cost = {0, 0, 35, 1, 0};
+
+            template<typename tT>
+            static constexpr bool supports = std::is_floating_point_v<tT>;
+
+            template<typename tT>
+            static tT apply(tT x)
+            {
+                return tT(1) / (tT(1) + std::exp(-x));
+            }
+
+            template<typename tT, typename tPacked>
+            static tPacked packed(const tPacked &x)
+            {
+                return packed_sigmoid<tT>(x);
+            }
+        };
+    }
+
+    namespace operations
+    {
+        /**
+         * Element-wise function of a vector or expression, evaluated in registers as part of the surrounding loop, so
+         * `exp(v) * 2.0 + 1.0` or `sum(log(v))` make a single pass without temporaries. Like Transpose it has no
+         * `tOperand`: scalar operations around it are not folded into the operand.
+         */
+        template<typename tOp, typename tFunc>
+        struct VecUnary
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            std::conditional_t<is_raw_vec<tOp>, const tOp &, const tOp> op;
+
+            using value_type = typename tOp::value_type;
+
+            static_assert(tFunc::template supports<value_type>, "element function not defined for this element type");
+
+            static constexpr impl::Cost own_cost = tFunc::cost;
+
+            VecUnary(const tOp &o)
+                : op(o)
+            {}
+
+            value_type operator[](size_t i) const
+            {
+                return tFunc::apply(op[i]);
+            }
+
+            size_t size() const
+            {
+                return op.size();
+            }
+
+        private:
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &, tPacked &) const
+            {}
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(op, i, v);
+                v = tFunc::template packed<value_type>(v);
+            }
+        };
+    }
+
+    // Nodes without a `tOperand` of their own that take scalar operations through the generic scalar nodes below.
+    template<typename>
+    constexpr bool is_elementwise_op = false;
+    template<typename tOp, typename tFunc>
+    constexpr bool is_elementwise_op<operations::VecUnary<tOp, tFunc>> = true;
+
+    template<Orientation tOrient, typename tOp, typename tFunc>
+    struct VecOrientationHelper<tOrient, operations::VecUnary<tOp, tFunc>>
+    {
+        constexpr static bool check()
+        {
+            if constexpr(tOrient == Orientation::OrientationRow)
+            {
+                return is_row<tOp>;
+            }
+            else
+            {
+                return is_col<tOp>;
+            }
+        }
+    };
+
+    namespace impl
+    {
+        template<typename tOp, typename tFunc>
+        struct FixedSizeOf<operations::VecUnary<tOp, tFunc>>
+        {
+            static constexpr size_t value = fixed_size_of<tOp>;
+        };
+
+        /**
+         * True when an expression contains an expensive element function. Such expressions cost far more per element
+         * than a memory pass, so InProd streams them through its kernel instead of evaluating them into a temporary first.
+         */
+        template<typename tOp, typename = void>
+        struct ComputeBound : std::false_type
+        {};
+
+        template<typename tOp>
+        struct ComputeBound<tOp, std::void_t<typename tOp::tOperand>> : ComputeBound<typename tOp::tOperand>
+        {};
+
+        template<typename tOp, typename tFunc>
+        struct ComputeBound<operations::VecUnary<tOp, tFunc>>
+            : std::bool_constant<(tFunc::cost.flops > 2 || tFunc::cost.divs > 0 || ComputeBound<tOp>::value)>
+        {};
+
+        template<typename tOp>
+        constexpr bool compute_bound = ComputeBound<tOp>::value;
+    }
+
+    // Element-wise exp; within 1.5 ulp of the exact result in the packed loops.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto exp(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::ExpFunc>(v);
+    }
+
+    // Element-wise natural logarithm; within 1 ulp. Denormal elements are not supported.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto log(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::LogFunc>(v);
+    }
+
+    // Element-wise square root; correctly rounded.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto sqrt(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::SqrtFunc>(v);
+    }
+
+    // Element-wise 1 / sqrt(x) at full precision, not the hardware estimate; within 1.5 ulp.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto rsqrt(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::RsqrtFunc>(v);
+    }
+
+    // Element-wise absolute value, for floating point and signed integer vectors.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto abs(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::AbsFunc>(v);
+    }
+
+    // Element-wise tanh; within 3 ulp.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto tanh(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::TanhFunc>(v);
+    }
+
+    // Element-wise logistic function 1 / (1 + exp(-x)); within 3 ulp.
+    template<typename tVec, std::enable_if_t<is_vec<tVec>, int> = 0>
+    auto sigmoid(const tVec &v)
+    {
+        return operations::VecUnary<tVec, impl::SigmoidFunc>(v);
+    }
+}
+
+// Scalar operations on element-wise nodes wrap them in the usual scalar nodes, which keep folding among themselves.
+template < typename tOp, typename tT, typename std::enable_if_t < ::lineal::is_elementwise_op<tOp> &&::lineal::is_numeric<tT>, int > = 0 >
+auto operator+(const tOp &op, const tT &t)
+{
+    return ::lineal::operations::VecPlusScalar<tOp, tT>(op, t);
+}
+
+template < typename tOp, typename tT, typename std::enable_if_t < ::lineal::is_elementwise_op<tOp> &&::lineal::is_numeric<tT>, int > = 0 >
+auto operator-(const tOp &op, const tT &t)
+{
+    return ::lineal::operations::VecMinusScalar<tOp, tT>(op, t);
+}
+
+template < typename tOp, typename tT, typename std::enable_if_t < ::lineal::is_elementwise_op<tOp> &&::lineal::is_numeric<tT>, int > = 0 >
+auto operator-(const tT &t, const tOp &op)
+{
+    return ::lineal::operations::ScalarMinusVec<tOp, tT>(op, t);
+}
+
+template < typename tOp, typename tT, typename std::enable_if_t < ::lineal::is_elementwise_op<tOp> &&::lineal::is_numeric<tT>, int > = 0 >
+auto operator/(const tOp &op, const tT &t)
+{
+    return ::lineal::operations::VecDivScalar<tOp, tT>(op, t);
+}
+
+template < typename tOp, typename tT, typename std::enable_if_t < ::lineal::is_elementwise_op<tOp> &&::lineal::is_numeric<tT>, int > = 0 >
+auto operator/(const tT &t, const tOp &op)
+{
+    return ::lineal::operations::ScalarDivVec<tOp, tT>(op, t);
+}
@@ -24,7 +24,20 @@
  * @endcond
  */
 #pragma once
+#include "lineal/vec_scalar_op.h"
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/async.h"
+#include "lineal/parallel.h"
+#include "lineal/eval.h"
 #include "lineal/memory.h"
+#include "lineal/tuning.h"
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <utility>
 
 namespace lineal
 {
@@ -35,8 +48,8 @@ namespace lineal
 
         using value_type = tT;
 
-        Vec(size_t size = 0, const ::lineal::fill &fill = ::lineal::fill::none)
-            : m_memory(size, fill),
+        Vec(size_t size = 0, const ::lineal::fill &fill = ::lineal::fill::none, std::pmr::memory_resource *resource = nullptr)
+            : m_memory(size, fill, resource),
               m_raw(m_memory.raw())
         {
         }
@@ -47,11 +60,57 @@ namespace lineal
         {
         }
 
+        Vec(lineal::impl::Memory<tT> &&memory)
+            : m_memory(std::move(memory)),
+              m_raw(m_memory.raw())
+        {
+        }
+
         Vec(const Vec &) = delete;
 
+        Vec(Vec &&other)
+            : m_memory(std::move(other.m_memory)),
+              m_raw(m_memory.raw())
+        {
+        }
+
+        Vec &operator=(Vec &&other)
+        {
+            m_memory = std::move(other.m_memory);
+            m_raw = m_memory.raw();
+            return *this;
+        }
+
+        template<typename tOp, typename = std::enable_if_t<is_vec_op<tOp>>>
+        Vec &operator=(const tOp &op)
+        {
+            check_assignable(op);
+            impl::assign(writable(), op, size());
+            return *this;
+        }
+
+        // `*this = op` with an explicit memory policy, e.g. MemoryPolicy::streaming() for outputs read much later.
+        template<typename tOp, typename = std::enable_if_t<is_vec_op<tOp>>>
+        Vec &assign(const tOp &op, const MemoryPolicy &policy)
+        {
+            check_assignable(op);
+            impl::assign(writable(), op, size(), policy);
+            return *this;
+        }
+
+        template<typename tOp, typename = std::enable_if_t<is_vec_op<tOp>>>
+        Future<void> assign_async(const tOp &op)
+        {
+            check_assignable(op);
+            return impl::async([out = writable(), count = size(), expr = impl::Capture<tOp>(op)]()
+            {
+                impl::assign(out, expr.get(), count);
+            });
+        }
+
         tT &operator[](const size_t i)
         {
-            return m_raw[i];
+            return writable()[i];
         }
 
         const tT &operator[](const size_t i) const
@@ -61,12 +120,12 @@ namespace lineal
 
         tT *begin()
         {
-            return m_raw;
+            return writable();
         }
 
         tT *end()
         {
-            return m_raw + m_memory.size();
+            return writable() + m_memory.size();
         }
 
         size_t size() const
@@ -74,13 +133,47 @@ namespace lineal
             return m_memory.size();
         }
 
+        size_t capacity() const
+        {
+            return m_memory.capacity();
+        }
+
         const tT *data() const
         {
             return m_raw;
         }
 
+        const lineal::impl::Memory<tT> &memory() const
+        {
+            return m_memory;
+        }
+
     private:
 
+        // Expressions are evaluated in their own element type, so a narrowing store would silently lose precision.
+        template<typename tOp>
+        void check_assignable(const tOp &op) const
+        {
+            static_assert(std::is_same_v<typename tOp::value_type, tT>,
+                          "expression element type differs from the vector's; convert the scalars, e.g. row * 2.0f");
+            LINEAL_ASSERT(op.size() == size(), "expression and vector sizes differ");
+        }
+
+        // Every mutable access goes through here, so a shared buffer is copied before its first write.
+        tT *writable()
+        {
+            if constexpr(impl::copy_on_write)
+            {
+                if (m_memory.shared())
+                {
+                    m_memory.detach();
+                    m_raw = m_memory.raw();
+                }
+            }
+
+            return m_raw;
+        }
+
         lineal::impl::Memory<tT> m_memory;
         tT *m_raw;
     };
@@ -145,8 +238,36 @@ namespace lineal
         using tParent = Vec<tT>;
 
         using Vec::Vec;
+        using Vec::operator=;
 
         Col(const Col &) = delete;
+        Col(Col &&) = default;
+        Col &operator=(Col &&) = default;
+
+        Col subvec(size_t begin, size_t end)
+        {
+            return Col(this->begin() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        Row<tT> t()
+        {
+            return Row<tT>(this->begin(), this->size());
+        }
+
+        ConstRow<tT> t() const
+        {
+            return ConstRow<tT>(this->data(), this->size());
+        }
+
+        ConstCol<tT> subvec(size_t begin, size_t end) const
+        {
+            return ConstCol<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        StridedCol<tT> subvec(size_t begin, size_t end, size_t step) const
+        {
+            return StridedCol<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end, step), step);
+        }
     };
 
     template<typename tT>
@@ -159,6 +280,21 @@ namespace lineal
         using ConstVec::ConstVec;
 
         ConstCol(const ConstCol &) = delete;
+
+        ConstRow<tT> t() const
+        {
+            return ConstRow<tT>(this->data(), this->size());
+        }
+
+        ConstCol<tT> subvec(size_t begin, size_t end) const
+        {
+            return ConstCol<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        StridedCol<tT> subvec(size_t begin, size_t end, size_t step) const
+        {
+            return StridedCol<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end, step), step);
+        }
     };
 
     template<typename tT>
@@ -169,8 +305,36 @@ namespace lineal
         using tParent = Vec<tT>;
 
         using Vec::Vec;
+        using Vec::operator=;
 
         Row(const Row &) = delete;
+        Row(Row &&) = default;
+        Row &operator=(Row &&) = default;
+
+        Row subvec(size_t begin, size_t end)
+        {
+            return Row(this->begin() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        Col<tT> t()
+        {
+            return Col<tT>(this->begin(), this->size());
+        }
+
+        ConstCol<tT> t() const
+        {
+            return ConstCol<tT>(this->data(), this->size());
+        }
+
+        ConstRow<tT> subvec(size_t begin, size_t end) const
+        {
+            return ConstRow<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        StridedRow<tT> subvec(size_t begin, size_t end, size_t step) const
+        {
+            return StridedRow<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end, step), step);
+        }
     };
 
     template<typename tT>
@@ -183,35 +347,103 @@ namespace lineal
         using ConstVec::ConstVec;
 
         ConstRow(const ConstRow &) = delete;
+
+        ConstCol<tT> t() const
+        {
+            return ConstCol<tT>(this->data(), this->size());
+        }
+
+        ConstRow<tT> subvec(size_t begin, size_t end) const
+        {
+            return ConstRow<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end));
+        }
+
+        StridedRow<tT> subvec(size_t begin, size_t end, size_t step) const
+        {
+            return StridedRow<tT>(this->data() + begin, impl::subvec_count(this->size(), begin, end, step), step);
+        }
     };
 
-    template<typename tVec>
-    typename tVec::value_type sum(const tVec &v)
+    /**
+     * Returns a vector of the same type with the contents of `v`. With LINEAL_COPY_ON_WRITE both share one buffer until
+     * either is written to, and the writer moves to a copy: views and pointers taken from it beforehand keep reading
+     * the old buffer. Without it this is a plain copy.
+     */
+    template<typename tVec, typename = std::enable_if_t<std::is_base_of_v<Vec<typename tVec::value_type>, tVec>>>
+    tVec share(const tVec &v)
     {
-        using value_type = typename tVec::value_type;
+        return tVec(v.memory().share());
+    }
 
-        impl::Memory<value_type> tmp_simd(4, fill::zeros);
-        impl::PackedType<value_type> tmp_sum = ::simdpp::load(tmp_simd.raw());
+    namespace impl
+    {
+        template<typename tVec>
+        typename tVec::value_type sum_range(const tVec &v, size_t begin, size_t end,
+                                            const KernelConfig &config = kernel_config())
+        {
+            using value_type = typename tVec::value_type;
+            using tPackedHelper = PackedTypeHelper<value_type>;
 
-        size_t i = 0;
+            WrapSIMD<tVec> wrapped(v);
 
-        for (size_t iEnd = v.size() >> 2; i < iEnd; ++i)
-        {
-            impl::PackedType<value_type> tmp_vec = v.load_packed(i << 2);
-            tmp_sum = simdpp::add(tmp_sum, tmp_vec);
+            const size_t iBegin = begin / tPackedHelper::count;
+            size_t iEnd = end / tPackedHelper::count;
+
+            if constexpr(is_raw_vec<tVec>)
+            {
+                iEnd = packed_end<value_type>(v.size(), end, v);
+            }
+
+            iEnd = std::max(iBegin, iEnd);
+
+            const PackedType<value_type> tmp_sum = reduce_packed<value_type>(iBegin, iEnd, config, source_of(v),
+                                                   static_cast<const value_type *>(nullptr),
+                                                   [&](size_t i)
+            {
+                return PackedType<value_type>(wrapped.load_packed(i));
+            });
+
+            value_type res = ::simdpp::reduce_add(tmp_sum);
+
+            for (size_t i = iEnd * tPackedHelper::count; i < end; ++i)
+            {
+                res += v[i];
+            }
+
+            return res;
         }
+    }
 
-        simdpp::store(tmp_simd.raw(), tmp_sum);
-        value_type res = lineal::sum(tmp_simd);
+    template<typename tVec>
+    typename tVec::value_type sum(const tVec &v, const MemoryPolicy &policy = memory_policy())
+    {
+        using value_type = typename tVec::value_type;
 
-        i <<= 2;
+        LINEAL_COUNT(sum_elements, v.size());
+        LINEAL_TRACE(sum, v.size());
 
-        for (size_t iEnd = v.size(); i < iEnd; ++i)
+        if constexpr(is_fixed_vec<tVec>)
         {
-            res += v[i];
+            return impl::fixed_sum(v);
         }
+        else
+        {
+            const KernelConfig config = with_policy(kernel_config(), policy);
 
-        return res;
+            return impl::parallel_reduce<value_type>(v.size(), impl::chunk_size<value_type>(), [&v, &config](size_t begin, size_t end)
+            {
+                return impl::sum_range(v, begin, end, config);
+            }, std::plus<value_type>());
+        }
+    }
+
+    template<typename tVec>
+    Future<typename tVec::value_type> sum_async(const tVec &v)
+    {
+        return impl::async([vec = impl::Capture<tVec>(v)]()
+        {
+            return sum(vec.get());
+        });
     }
 
     template<typename tT>
@@ -24,10 +24,13 @@
  * @endcond
  */
 #pragma once
+#include "lineal/strided_vec.h"
 #include "lineal/types.h"
 
 #include<optional>
 #include<variant>
+#include <cstdint>
+#include <cstring>
 
 namespace lineal
 {
@@ -75,6 +78,224 @@ namespace lineal
 
     namespace impl
     {
+        /**
+         * Per-element work of an expression: elements loaded and stored, arithmetic operations (divisions included) and
+         * divisions, and the bytes moved. Nodes declare their own share as `own_cost`; OpCost adds up the tree.
+         */
+        struct Cost
+        {
+            size_t loads;
+            size_t stores;
+            size_t flops;
+            size_t divs;
+            size_t bytes;
+
+            constexpr Cost operator+(const Cost &other) const
+            {
+                return Cost{loads + other.loads, stores + other.stores, flops + other.flops, divs + other.divs, bytes + other.bytes};
+            }
+
+            // FLOPs per byte moved.
+            constexpr double intensity() const
+            {
+                return bytes == 0 ? 0.0 : double(flops) / double(bytes);
+            }
+        };
+
+        /**
+         * Coefficients of x -> (a * x + b) / (c * x + d). Every chain of scalar +, -, * and / around a vector is such a
+         * map, and composing two of them gives another one.
+         */
+        template<typename tT>
+        struct Mobius
+        {
+            tT a;
+            tT b;
+            tT c;
+            tT d;
+
+            template<typename tA, typename tB, typename tC, typename tD>
+            Mobius(const tA &a_, const tB &b_, const tC &c_, const tD &d_)
+                : a(static_cast<tT>(a_)),
+                  b(static_cast<tT>(b_)),
+                  c(static_cast<tT>(c_)),
+                  d(static_cast<tT>(d_))
+            {}
+
+            // Returns the map x -> this(inner(x)).
+            Mobius compose(const Mobius &inner) const
+            {
+                return Mobius(a * inner.a + b * inner.c, a * inner.b + b * inner.d,
+                              c * inner.a + d * inner.c, c * inner.b + d * inner.d);
+            }
+
+            bool is_affine() const
+            {
+                return c == tT(0);
+            }
+        };
+
+        template<typename tT>
+        bool is_register_aligned(const tT *ptr)
+        {
+            return reinterpret_cast<std::uintptr_t>(ptr) % sizeof(PackedType<tT>) == 0;
+        }
+
+        // Loads the register starting at element i of a leaf vector. Strided views are gathered through an aligned block;
+        // contiguous views that do not start on a register boundary use unaligned loads.
+        template<typename tVec, typename tPacked>
+        void load_raw(const tVec &vec, size_t i, tPacked &v, bool aligned)
+        {
+            using value_type = typename tVec::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+
+            if constexpr(is_strided_vec<tVec>)
+            {
+                alignas(sizeof(tPacked)) value_type block[count];
+
+                for (size_t k = 0; k < count; ++k)
+                {
+                    block[k] = vec[i + k];
+                }
+
+                v = simdpp::load(block);
+            }
+            else if (aligned)
+            {
+                v = simdpp::load(vec.data() + i);
+            }
+            else
+            {
+                v = simdpp::load_u(vec.data() + i);
+            }
+        }
+
+        /**
+         * Registers loaded so far for the current index of a fused loop, keyed by address, so that terms reading the same
+         * vector load each register once. Active on the constructing thread for the lifetime of the object.
+         */
+        struct SharedLoads
+        {
+            static constexpr size_t capacity = 8;
+
+            alignas(64) unsigned char values[capacity][64];
+            const void *keys[capacity];
+            size_t count = 0;
+
+            SharedLoads()
+                : m_previous(active())
+            {
+                active() = this;
+            }
+
+            SharedLoads(const SharedLoads &) = delete;
+
+            ~SharedLoads()
+            {
+                active() = m_previous;
+            }
+
+            static SharedLoads *&active()
+            {
+                thread_local SharedLoads *loads = nullptr;
+                return loads;
+            }
+
+            template<typename tVec, typename tPacked>
+            void load(const tVec &vec, size_t i, tPacked &v)
+            {
+                static_assert(sizeof(tPacked) <= sizeof(values[0]), "register wider than the shared load slots");
+
+                const void *key = vec.data() + i;
+
+                for (size_t k = 0; k < count; ++k)
+                {
+                    if (keys[k] == key)
+                    {
+                        std::memcpy(&v, values[k], sizeof(tPacked));
+                        return;
+                    }
+                }
+
+                load_raw(vec, i, v, is_register_aligned(vec.data()));
+
+                if (count < capacity)
+                {
+                    keys[count] = key;
+                    std::memcpy(values[count], &v, sizeof(tPacked));
+                    ++count;
+                }
+            }
+
+        private:
+
+            SharedLoads *m_previous;
+        };
+
+        // Operand a copied node refers to: its own copy of a nested node, or the same leaf vector as the source.
+        template<typename tVec, typename tHolder>
+        const tVec &copied_operand(const tHolder &holder, const tVec &source)
+        {
+            if constexpr(is_vec_op<tVec>)
+            {
+                return holder;
+            }
+            else
+            {
+                return source;
+            }
+        }
+
+        // Gives the evaluation kernels access to the packed interface of the operation nodes.
+        struct SIMDAccess
+        {
+            template<typename tVec, typename tPacked>
+            static void prepare(const tVec &vec, tPacked &s, tPacked &m)
+            {
+                vec.prepare_simd(s, m);
+            }
+
+            template<typename tVec, typename tPacked>
+            static void load(const tVec &vec, size_t i, tPacked &v, tPacked &s, tPacked &m)
+            {
+                vec.load_packed(i, v, s, m);
+            }
+
+            // Loads the register starting at element i of the operand of a node, which is either a vector or a nested node.
+            template<typename tVec, typename tPacked>
+            static void load_operand(const tVec &vec, size_t i, tPacked &v)
+            {
+                if constexpr(is_raw_vec<tVec> && !is_strided_vec<tVec>)
+                {
+                    if (SharedLoads *loads = SharedLoads::active())
+                    {
+                        loads->load(vec, i, v);
+                    }
+                    else
+                    {
+                        load_raw(vec, i, v, is_register_aligned(vec.data()));
+                    }
+                }
+                else if constexpr(is_raw_vec<tVec>)
+                {
+                    load_raw(vec, i, v, is_register_aligned(vec.data()));
+                }
+                else
+                {
+                    tPacked s, m;
+                    prepare(vec, s, m);
+                    load(vec, i, v, s, m);
+                }
+            }
+
+            // Evaluates the comparison mask of element i onward, as lanes of `tPacked`.
+            template<typename tPacked, typename tMask>
+            static typename tPacked::mask_vector_type load_mask(const tMask &mask, size_t i)
+            {
+                return mask.template load_mask<tPacked>(i);
+            }
+        };
+
         template<typename tVec>
         struct WrapRawSIMD
         {
@@ -84,18 +305,20 @@ namespace lineal
             const tVec &vec;
 
             WrapRawSIMD(const tVec &v)
-                : vec(v)
+                : vec(v),
+                  m_aligned(is_register_aligned(v.data()))
             {}
 
             auto &load_packed(size_t i)
             {
-                m_packed = simdpp::load(vec.data() + i * tPackedHelper::count);
+                load_raw(vec, i * tPackedHelper::count, m_packed, m_aligned);
                 return m_packed;
             }
 
         private:
 
             tPacked m_packed;
+            bool m_aligned;
         };
 
         template<typename tVec>
@@ -109,12 +332,12 @@ namespace lineal
             WrapOpSIMD(const tVec &v)
                 : vec(v)
             {
-                vec.prepare_simd(m_scalar, m_mul);
+                SIMDAccess::prepare(vec, m_scalar, m_mul);
             }
 
             auto &load_packed(size_t i)
             {
-                vec.load_packed(i * tPackedHelper::count, m_packed, m_scalar, m_mul);
+                SIMDAccess::load(vec, i * tPackedHelper::count, m_packed, m_scalar, m_mul);
                 return m_packed;
             }
 
@@ -138,11 +361,13 @@ namespace lineal
         {
             template<typename>
             friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
 
             const tVec &vec;
             const tT scalar;
             impl::PackedType<tT> simd_scalar;
 
+            using tOperand = tVec;
             using value_type = PreciseType<typename tVec::value_type, tT>;
 
             template<typename = std::enable_if_t<is_vec_op<tVec>>, typename = bool>
@@ -158,6 +383,14 @@ namespace lineal
                                                        scalar(t)
             {}
 
+            // Nested nodes live in vec_holder, so a copy must refer to its own holder rather than the source's.
+            VecScalarOp(const VecScalarOp &other)
+                : vec(impl::copied_operand(vec_holder, other.vec)),
+                  scalar(other.scalar),
+                  simd_scalar(other.simd_scalar),
+                  vec_holder(other.vec_holder)
+            {}
+
             size_t size() const
             {
                 return vec.size();
@@ -179,10 +412,13 @@ namespace lineal
         {
             template<typename>
             friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
 
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -200,12 +436,18 @@ namespace lineal
                 return apply(vec[i]);
             }
 
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(1, scalar, 0, 1);
+            }
+
         private:
 
             template<typename tPacked>
             void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
             {
-                v = simdpp::load(vec.data() + i);
+                impl::SIMDAccess::load_operand(vec, i, v);
                 v = simdpp::add(v, s);
             }
         };
@@ -213,9 +455,15 @@ namespace lineal
         template<typename tVec, typename tT>
     struct VecMinusScalar : VecScalarOp<tVec, tT>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -232,14 +480,35 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(1, -scalar, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(v, s);
+            }
         };
 
         template<typename tVec, typename tT>
     struct ScalarMinusVec : VecScalarOp<tVec, tT>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -256,14 +525,35 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(-1, scalar, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(s, v);
+            }
         };
 
         template<typename tVec, typename tT>
     struct VecTimesScalar : VecScalarOp<tVec, tT>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 0, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -280,14 +570,35 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(scalar, 0, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::mul(s, v);
+            }
         };
 
         template<typename tVec, typename tT>
     struct VecDivScalar : VecScalarOp<tVec, tT>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 1, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -304,14 +615,35 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(1, 0, 0, scalar);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::div(v, s);
+            }
         };
 
         template<typename tVec, typename tT>
     struct ScalarDivVec : VecScalarOp<tVec, tT>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = typename VecScalarOp<tVec, tT>;
             using tParent::VecScalarOp;
 
+            static constexpr impl::Cost own_cost = {0, 0, 1, 1, 0};
+
             template<typename tV>
             auto apply(const tV &v) const
             {
@@ -328,37 +660,90 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(0, scalar, 1, 0);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::div(s, v);
+            }
         };
 
 
         template<typename tVec, typename tM, typename tA>
         struct VecFMABase
         {
+            friend struct impl::SIMDAccess;
+
             const tVec &vec;
             const tA scalar;
             const tM mul;
 
+            template<typename = std::enable_if_t<is_vec_op<tVec>>, typename = bool>
+            VecFMABase(const tVec &v, const tM &m, const tA &a)
+                : vec(vec_holder),
+                  scalar(a),
+                  mul(m),
+                  vec_holder(v)
+            {}
+
+            template<typename = std::enable_if_t<is_raw_vec<tVec>>>
             VecFMABase(const tVec &v, const tM &m, const tA &a)
                 : vec(v),
                   scalar(a),
                   mul(m)
             {}
 
+            VecFMABase(const VecFMABase &other)
+                : vec(impl::copied_operand(vec_holder, other.vec)),
+                  scalar(other.scalar),
+                  mul(other.mul),
+                  vec_holder(other.vec_holder)
+            {}
+
+            using tOperand = tVec;
             using value_type = typename PreciseType<typename tVec::value_type, tM, tA>;
 
             size_t size() const
             {
                 return vec.size();
             }
+
+        protected:
+
+            typename std::conditional_t<is_vec_op<tVec>, tVec, constexpr bool> vec_holder;
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &s, tPacked &m) const
+            {
+                const value_type a = scalar;
+                const value_type b = mul;
+                s = simdpp::load_splat(&a);
+                m = simdpp::load_splat(&b);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFMA : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 0, 0};
+
             auto sub_operation() const
             {
                 return mul * vec;
@@ -380,15 +765,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(mul, scalar, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::add(simdpp::mul(v, m), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFMAVecMinusScalar : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 0, 0};
+
             auto sub_operation() const
             {
                 return mul * vec;
@@ -410,15 +816,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(mul, -scalar, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(simdpp::mul(v, m), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFMAScalarMinusVec : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 0, 0};
+
             auto sub_operation() const
             {
                 return mul * vec;
@@ -440,15 +867,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(-mul, scalar, 0, 1);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(s, simdpp::mul(v, m));
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDA : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return vec / mul;;
@@ -470,15 +918,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(1, scalar * mul, 0, mul);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::add(simdpp::div(v, m), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDAVecMinusScalar : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return vec / mul;
@@ -500,15 +969,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(1, -scalar * mul, 0, mul);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(simdpp::div(v, m), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDAScalarMinusVec : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return vec / mul;
@@ -530,15 +1020,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(-1, scalar * mul, 0, mul);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(s, simdpp::div(v, m));
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDAInv : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return mul / vec;
@@ -560,15 +1071,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(scalar, mul, 1, 0);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::add(simdpp::div(m, v), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDAInvVecMinusScalar : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return mul / vec;
@@ -590,15 +1122,36 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(-scalar, mul, 1, 0);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(simdpp::div(m, v), s);
+            }
         };
 
         template<typename tVec, typename tM, typename tA>
     struct VecFDAInvScalarMinusVec : VecFMABase<tVec, tM, tA>
         {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
             using tParent = VecFMABase<tVec, tM, tA>;
             using tParent::VecFMABase;
             using value_type = typename tParent::value_type;
 
+            static constexpr impl::Cost own_cost = {0, 0, 2, 1, 0};
+
             auto sub_operation() const
             {
                 return mul / vec;
@@ -620,11 +1173,348 @@ namespace lineal
             {
                 return apply(vec[i]);
             }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(scalar, -mul, 1, 0);
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::sub(s, simdpp::div(m, v));
+            }
+        };
+
+        /**
+         * Canonical form of a scalar chain around `vec`, with coefficients (a * vec + b) / (c * vec + d). Chains that
+         * never divide by the vector have c == 0 and d == 1 and become a VecAffine, one multiply-add per element; the
+         * others become a VecRational. Only floating point chains are folded, since integer division does not compose.
+         */
+        template<typename tVec, typename tT>
+        struct VecMobiusBase
+        {
+            friend struct impl::SIMDAccess;
+
+            using tOperand = tVec;
+            using value_type = PreciseType<typename tVec::value_type, tT>;
+
+            static_assert(std::is_floating_point_v<value_type>, "only floating point chains fold into coefficients");
+
+            const tVec &vec;
+            const impl::Mobius<value_type> coefficients;
+
+            template<typename = std::enable_if_t<is_vec_op<tVec>>, typename = bool>
+            VecMobiusBase(const tVec &v, const impl::Mobius<value_type> &m)
+                : vec(vec_holder),
+                  coefficients(m),
+                  vec_holder(v)
+            {}
+
+            template<typename = std::enable_if_t<is_raw_vec<tVec>>>
+            VecMobiusBase(const tVec &v, const impl::Mobius<value_type> &m)
+                : vec(v),
+                  coefficients(m)
+            {}
+
+            VecMobiusBase(const VecMobiusBase &other)
+                : vec(impl::copied_operand(vec_holder, other.vec)),
+                  coefficients(other.coefficients),
+                  vec_holder(other.vec_holder)
+            {}
+
+            size_t size() const
+            {
+                return vec.size();
+            }
+
+            template<typename tV>
+            impl::Mobius<tV> mobius() const
+            {
+                return impl::Mobius<tV>(coefficients.a, coefficients.b, coefficients.c, coefficients.d);
+            }
+
+        protected:
+
+            typename std::conditional_t<is_vec_op<tVec>, tVec, constexpr bool> vec_holder;
+
+            // The coefficients are composed in the wider of the node and scalar types, so integer scalars never truncate them.
+            template<typename tS>
+            auto composed(const impl::Mobius<tS> &outer) const
+            {
+                using tResult = PreciseType<value_type, tS>;
+
+                return impl::Mobius<tResult>(outer.a, outer.b, outer.c, outer.d).compose(mobius<tResult>());
+            }
+
+            template<typename tPacked>
+            void prepare_simd(tPacked &s, tPacked &m) const
+            {
+                s = simdpp::load_splat(&coefficients.b);
+                m = simdpp::load_splat(&coefficients.a);
+            }
+        };
+
+        template<typename tVec, typename tT>
+        struct VecRational : VecMobiusBase<tVec, tT>
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            using tParent = typename VecMobiusBase<tVec, tT>;
+            using tParent::VecMobiusBase;
+
+            static constexpr impl::Cost own_cost = {0, 0, 5, 1, 0};
+
+            template<typename tV>
+            auto apply(const tV &v) const
+            {
+                return (coefficients.a * v + coefficients.b) / (coefficients.c * v + coefficients.d);
+            }
+
+            value_type operator[](size_t i) const
+            {
+                return apply(vec[i]);
+            }
+
+            template<typename tS>
+            auto compose(const impl::Mobius<tS> &outer) const
+            {
+                return VecRational<tVec, PreciseType<value_type, tS>>(vec, composed(outer));
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+
+                tPacked c = simdpp::load_splat(&coefficients.c);
+                tPacked d = simdpp::load_splat(&coefficients.d);
+                v = simdpp::div(simdpp::add(simdpp::mul(v, m), s), simdpp::add(simdpp::mul(v, c), d));
+            }
+        };
+
+        template<typename tVec, typename tT>
+        struct VecAffine : VecMobiusBase<tVec, tT>
+        {
+            template<typename>
+            friend struct impl::WrapOpSIMD;
+            friend struct impl::SIMDAccess;
+
+            using tParent = typename VecMobiusBase<tVec, tT>;
+            using tParent::VecMobiusBase;
+
+            static constexpr impl::Cost own_cost = {0, 0, 2, 0, 0};
+
+            template<typename tV>
+            auto apply(const tV &v) const
+            {
+                return coefficients.a * v + coefficients.b;
+            }
+
+            value_type operator[](size_t i) const
+            {
+                return apply(vec[i]);
+            }
+
+            // Outer maps from +, -, * and / by a scalar keep the chain affine; the constant denominator is divided out.
+            template<typename tS>
+            auto compose_affine(const impl::Mobius<tS> &outer) const
+            {
+                using tResult = PreciseType<value_type, tS>;
+                const impl::Mobius<tResult> m = composed(outer);
+
+                return VecAffine<tVec, tResult>(vec, impl::Mobius<tResult>(m.a / m.d, m.b / m.d, 0, 1));
+            }
+
+            template<typename tS>
+            auto compose(const impl::Mobius<tS> &outer) const
+            {
+                return VecRational<tVec, PreciseType<value_type, tS>>(vec, composed(outer));
+            }
+
+        private:
+
+            template<typename tPacked>
+            void load_packed(size_t i, tPacked &v, tPacked &s, tPacked &m) const
+            {
+                impl::SIMDAccess::load_operand(vec, i, v);
+                v = simdpp::add(simdpp::mul(v, m), s);
+            }
         };
 
         template<typename tVec, typename tT>
         constexpr bool valid_for_vec_scalar_op = ::lineal::is_raw_vec<tVec> &&::lineal::is_numeric<tT>;
     }
+
+    namespace impl
+    {
+        // Scalar operation nodes whose map divides by their operand; all others are affine.
+        template<typename>
+        constexpr bool divides_by_operand = false;
+        template<typename tVec, typename tT>
+        constexpr bool divides_by_operand<operations::ScalarDivVec<tVec, tT>> = true;
+        template<typename tVec, typename tM, typename tA>
+        constexpr bool divides_by_operand<operations::VecFDAInv<tVec, tM, tA>> = true;
+        template<typename tVec, typename tM, typename tA>
+        constexpr bool divides_by_operand<operations::VecFDAInvVecMinusScalar<tVec, tM, tA>> = true;
+        template<typename tVec, typename tM, typename tA>
+        constexpr bool divides_by_operand<operations::VecFDAInvScalarMinusVec<tVec, tM, tA>> = true;
+        template<typename tVec, typename tT>
+        constexpr bool divides_by_operand<operations::VecRational<tVec, tT>> = true;
+
+        // Walks a chain of scalar operation nodes down to the first operand that is not one, composing the coefficients.
+        template<typename tOp, typename = void>
+        struct AffineForm
+        {
+            using tLeaf = tOp;
+
+            static constexpr bool affine = true;
+
+            static const tLeaf &leaf(const tOp &op)
+            {
+                return op;
+            }
+
+            template<typename tT>
+            static Mobius<tT> coefficients(const tOp &)
+            {
+                return Mobius<tT>(1, 0, 0, 1);
+            }
+        };
+
+        template<typename tOp>
+        struct AffineForm<tOp, std::void_t<typename tOp::tOperand>>
+        {
+            using tInner = AffineForm<typename tOp::tOperand>;
+            using tLeaf = typename tInner::tLeaf;
+
+            static constexpr bool affine = !divides_by_operand<tOp> && tInner::affine;
+
+            static const tLeaf &leaf(const tOp &op)
+            {
+                return tInner::leaf(op.vec);
+            }
+
+            template<typename tT>
+            static Mobius<tT> coefficients(const tOp &op)
+            {
+                return op.template mobius<tT>().compose(tInner::template coefficients<tT>(op.vec));
+            }
+        };
+
+        template<typename tOp>
+        auto canonical(const tOp &op)
+        {
+            using tForm = AffineForm<tOp>;
+            using tLeaf = typename tForm::tLeaf;
+            using value_type = typename tOp::value_type;
+
+            const Mobius<value_type> m = tForm::template coefficients<value_type>(op);
+
+            if constexpr(tForm::affine)
+            {
+                return operations::VecAffine<tLeaf, value_type>(tForm::leaf(op), Mobius<value_type>(m.a / m.d, m.b / m.d, 0, 1));
+            }
+            else
+            {
+                return operations::VecRational<tLeaf, value_type>(tForm::leaf(op), m);
+            }
+        }
+
+        // t / op. Floating point chains fold into a single rational node; integer chains keep the nested node.
+        template<typename tT, typename tOp>
+        auto scalar_div(const tT &t, const tOp &op)
+        {
+            if constexpr(std::is_floating_point_v<typename tOp::value_type>)
+            {
+                return canonical(op).compose(Mobius<tT>(0, t, 1, 0));
+            }
+            else
+            {
+                return operations::ScalarDivVec<tOp, tT>(op, t);
+            }
+        }
+    }
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator+(const ::lineal::operations::VecRational<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(1, t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const ::lineal::operations::VecRational<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(1, -t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const tT &t, const ::lineal::operations::VecRational<tVec0, tT0> &op)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(-1, t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator*(const ::lineal::operations::VecRational<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(t, 0, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const ::lineal::operations::VecRational<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(1, 0, 0, t));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const tT &t, const ::lineal::operations::VecRational<tVec0, tT0> &op)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(0, t, 1, 0));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator+(const ::lineal::operations::VecAffine<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose_affine(::lineal::impl::Mobius<tT>(1, t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const ::lineal::operations::VecAffine<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose_affine(::lineal::impl::Mobius<tT>(1, -t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator-(const tT &t, const ::lineal::operations::VecAffine<tVec0, tT0> &op)
+{
+    return op.compose_affine(::lineal::impl::Mobius<tT>(-1, t, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator*(const ::lineal::operations::VecAffine<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose_affine(::lineal::impl::Mobius<tT>(t, 0, 0, 1));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const ::lineal::operations::VecAffine<tVec0, tT0> &op, const tT &t)
+{
+    return op.compose_affine(::lineal::impl::Mobius<tT>(1, 0, 0, t));
+}
+
+template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
+auto operator/(const tT &t, const ::lineal::operations::VecAffine<tVec0, tT0> &op)
+{
+    return op.compose(::lineal::impl::Mobius<tT>(0, t, 1, 0));
 }
 
 template<typename tVec, typename tT, typename std::enable_if_t<::lineal::vec_scalar_type<tVec, tT>, int> = 0>
@@ -806,7 +1696,7 @@ auto operator-(const tT &t, const ::lineal::operations::VecDivScalar<tVec0, tT0>
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator-(const ::lineal::operations::ScalarDivVec<tVec0, tT0> &op, const tT &t)
 {
-    return ::lineal::operations::VecFDAInvVecMinusScalar(op.vec, op.scalar, t);
+    return ::lineal::operations::VecFDAInvVecMinusScalar<tVec0, tT0, tT>(op.vec, op.scalar, t);
 }
 
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1027,7 +1917,7 @@ auto operator*(const ::lineal::operations::VecFDAScalarMinusVec<tVec0, tM0, tA0>
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator*(const ::lineal::operations::VecFDAInvScalarMinusVec<tVec0, tM0, tA0> &op, const tT &t)
 {
-    return (op.scalar * t) - ((op.scalar * t) / op.vec);
+    return (op.scalar * t) - ((op.mul * t) / op.vec);
 }
 
 
@@ -1056,7 +1946,7 @@ auto operator/(const ::lineal::operations::VecPlusScalar<tVec0, tT0> &op, const
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecPlusScalar<tVec0, tT0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecPlusScalar<tVec0, tT0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1068,7 +1958,7 @@ auto operator/(const ::lineal::operations::VecMinusScalar<tVec0, tT0> &op, const
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecMinusScalar<tVec0, tT0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecMinusScalar<tVec0, tT0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1080,7 +1970,7 @@ auto operator/(const ::lineal::operations::ScalarMinusVec<tVec0, tT0> &op, const
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::ScalarMinusVec<tVec0, tT0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::ScalarMinusVec<tVec0, tT0>, tT0>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tT0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1140,19 +2030,19 @@ auto operator/(const ::lineal::operations::VecFDAInv<tVec0, tM0, tA0> &op, const
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFMA<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFMA<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDA<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDA<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDAInv<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDAInv<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1176,19 +2066,19 @@ auto operator/(const ::lineal::operations::VecFDAInvVecMinusScalar<tVec0, tM0, t
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFMAVecMinusScalar<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFMAVecMinusScalar<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDAVecMinusScalar<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDAVecMinusScalar<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDAInvVecMinusScalar<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDAInvVecMinusScalar<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
@@ -1212,19 +2102,19 @@ auto operator/(const ::lineal::operations::VecFDAInvScalarMinusVec<tVec0, tM0, t
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFMAScalarMinusVec<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFMAScalarMinusVec<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDAScalarMinusVec<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDAScalarMinusVec<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 template<typename tVec0, typename tM0, typename tA0, typename tT, typename std::enable_if_t<::lineal::is_numeric<tT>, int> = 0>
 auto operator/(const tT &t, const ::lineal::operations::VecFDAInvScalarMinusVec<tVec0, tM0, tA0> &op)
 {
-    return ::lineal::operations::ScalarDivVec<::lineal::operations::VecFDAScalarMinusVec<tVec0, tM0, tA0>, tT>(op, t);
+    return ::lineal::impl::scalar_div(t, op);
 }
 
 // Vec and scalar
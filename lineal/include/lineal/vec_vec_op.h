@@ -25,14 +25,147 @@
  */
 #pragma once
 #include "lineal/vec_scalar_op.h"
+#include "lineal/fixed_vec.h"
+#include "lineal/async.h"
+#include "lineal/counters.h"
+#include "lineal/tracing.h"
+#include "lineal/parallel.h"
+#include "lineal/scratch.h"
+#include "lineal/tuning.h"
+#include "lineal/unary.h"
 #include "lineal/types.h"
 
 #include <mkl.h>
 
+#include <algorithm>
+#include <functional>
 #include <numeric>
 
 namespace lineal
 {
+    namespace impl
+    {
+        // True when the range runs to the end of both vectors and both carry zeroed register padding.
+        template<typename tRow, typename tCol>
+        bool padded_tail(const tRow &row, const tCol &col, size_t end)
+        {
+            using value_type = typename tRow::value_type;
+            constexpr size_t count = PackedTypeHelper<value_type>::count;
+
+            return end % count != 0 && packed_end<value_type>(row.size(), end, row, col) * count > end;
+        }
+
+        template<typename tRow, typename tCol>
+        typename tRow::value_type inprod_packed_range(const tRow &row, const tCol &col, size_t begin, size_t end,
+                const KernelConfig &config = kernel_config())
+        {
+            using value_type = typename tRow::value_type;
+            using tPackedHelper = PackedTypeHelper<value_type>;
+
+            WrapSIMD<tRow> v0(row);
+            WrapSIMD<tCol> v1(col);
+
+            const size_t iBegin = begin / tPackedHelper::count;
+            const size_t iEnd = std::max(iBegin, packed_end<value_type>(row.size(), end, row, col));
+
+            const PackedType<value_type> tmp_inprod = reduce_packed<value_type>(iBegin, iEnd, config, source_of(row),
+                    source_of(col), [&](size_t i)
+            {
+                return PackedType<value_type>(::simdpp::mul(v0.load_packed(i), v1.load_packed(i)));
+            });
+
+            value_type res = ::simdpp::reduce_add(tmp_inprod);
+
+            for (size_t i = iEnd * tPackedHelper::count; i < end; ++i)
+            {
+                res += row[i] * col[i];
+            }
+
+            return res;
+        }
+
+        // Evaluates `op` into the temporary `out`, converting element by element when the element types differ.
+        template<typename tOut, typename tOp>
+        void convert_into(tOut &out, const tOp &op)
+        {
+            using tT = typename tOut::value_type;
+
+            if constexpr(std::is_same_v<typename tOp::value_type, tT>)
+            {
+                out = op;
+            }
+            else
+            {
+                for (size_t i = 0, end = op.size(); i < end; ++i)
+                {
+                    out[i] = static_cast<tT>(op[i]);
+                }
+            }
+        }
+
+        // With `blas` false, float and double ranges always take the inline kernel, e.g. to honour a memory policy.
+        template<typename tRow, typename tCol>
+        PreciseType<typename tRow::value_type, typename tCol::value_type> inprod_range(const tRow &row, const tCol &col,
+                size_t begin, size_t end, const KernelConfig &config = kernel_config(), bool blas = true)
+        {
+            using tRowValue = typename tRow::value_type;
+            using tColValue = typename tCol::value_type;
+            using value_type = PreciseType<tRowValue, tColValue>;
+
+            const int N = static_cast<int>(end - begin);
+
+            if constexpr(std::is_same_v<tRowValue, double> && std::is_same_v<tColValue, double>)
+            {
+                if (blas && (size_t(N) >= blas_crossover<value_type>(config) || !padded_tail(row, col, end)))
+                {
+                    LINEAL_COUNT(blas_calls, 1);
+
+                    const size_t row_stride = stride_of(row);
+                    const size_t col_stride = stride_of(col);
+
+                    return cblas_ddot(N, row.data() + begin * row_stride, static_cast<int>(row_stride),
+                                       col.data() + begin * col_stride, static_cast<int>(col_stride));
+                }
+
+                LINEAL_COUNT(inline_calls, 1);
+                return inprod_packed_range(row, col, begin, end, config);
+            }
+            else if constexpr(std::is_same_v<tRowValue, float> && std::is_same_v<tColValue, float>)
+            {
+                if (blas && (size_t(N) >= blas_crossover<value_type>(config) || !padded_tail(row, col, end)))
+                {
+                    LINEAL_COUNT(blas_calls, 1);
+
+                    const size_t row_stride = stride_of(row);
+                    const size_t col_stride = stride_of(col);
+
+                    return cblas_sdot(N, row.data() + begin * row_stride, static_cast<int>(row_stride),
+                                       col.data() + begin * col_stride, static_cast<int>(col_stride));
+                }
+
+                LINEAL_COUNT(inline_calls, 1);
+                return inprod_packed_range(row, col, begin, end, config);
+            }
+            else if constexpr(std::is_same_v<tRowValue, tColValue>)
+            {
+                LINEAL_COUNT(inline_calls, 1);
+                return inprod_packed_range(row, col, begin, end, config);
+            }
+            else
+            {
+                LINEAL_COUNT(inline_calls, 1);
+                value_type res = 0;
+
+                for (size_t i = begin; i < end; ++i)
+                {
+                    res += row[i] * col[i];
+                }
+
+                return res;
+            }
+        }
+    }
+
     namespace operations
     {
         template<typename tVec0, typename tVec1>
@@ -71,6 +204,14 @@ namespace lineal
                   vec1(v1)
             {}
 
+            // Nested nodes live in the holders, so a copy must refer to its own holders rather than the source's.
+            VecVecOp(const VecVecOp &other)
+                : vec0(impl::copied_operand(vec0_holder, other.vec0)),
+                  vec1(impl::copied_operand(vec1_holder, other.vec1)),
+                  vec0_holder(other.vec0_holder),
+                  vec1_holder(other.vec1_holder)
+            {}
+
             size_t size() const
             {
                 return vec0.size();
@@ -107,6 +248,8 @@ namespace lineal
             template < typename = std::enable_if_t < is_vec_op<tRow> || is_vec_op<tCol >> >
             value_type eval() const
             {
+                LINEAL_TRACE(inprod_expr, vec0.size());
+
                 //                 size_t i = 0;
                 //
                 //                 value_type init = 0;
@@ -129,35 +272,83 @@ namespace lineal
                 //                     tmp += vec0[i] * vec1[i];
                 //                 }
 
-                if constexpr(is_vec_op<tCol>)
+                if constexpr((impl::compute_bound<tRow> || impl::compute_bound<tCol>) &&
+                             std::is_same_v<typename tRow::value_type, typename tCol::value_type>)
                 {
-                    lineal::Col<value_type> tmp_col(vec1.size());
-
-                    for (size_t i = 0; i < vec0.size(); ++i)
+                    // Element functions are evaluated in registers next to the multiply instead of into a temporary.
+                    return impl::parallel_reduce<value_type>(vec0.size(), impl::chunk_size<value_type>(), [this](size_t begin, size_t end)
                     {
-                        tmp_col[i] = vec1[i];
-                    }
+                        return impl::inprod_packed_range(vec0, vec1, begin, end);
+                    }, std::plus<value_type>());
+                }
+                else if constexpr(is_vec_op<tCol> && impl::fixed_size_of<tCol> != 0)
+                {
+                    lineal::FixedCol<value_type, impl::fixed_size_of<tCol>> tmp_col;
+                    LINEAL_COUNT(temporaries, 1);
+
+                    impl::convert_into(tmp_col, vec1);
+
+                    return vec0 * tmp_col;
+                }
+                else if constexpr(is_vec_op<tRow> && impl::fixed_size_of<tRow> != 0)
+                {
+                    lineal::FixedRow<value_type, impl::fixed_size_of<tRow>> tmp_row;
+                    LINEAL_COUNT(temporaries, 1);
+
+                    impl::convert_into(tmp_row, vec0);
+
+                    return tmp_row * vec1;
+                }
+                else if constexpr(is_vec_op<tCol>)
+                {
+                    impl::ScratchScope scratch;
+                    lineal::Col<value_type> tmp_col(vec1.size(), ::lineal::fill::none, scratch.resource());
+                    LINEAL_COUNT(temporaries, 1);
+
+                    impl::convert_into(tmp_col, vec1);
 
                     return vec0 * tmp_col;
                 }
                 else
                 {
-                    lineal::Row<value_type> tmp_row(vec0.size());
+                    impl::ScratchScope scratch;
+                    lineal::Row<value_type> tmp_row(vec0.size(), ::lineal::fill::none, scratch.resource());
+                    LINEAL_COUNT(temporaries, 1);
 
-                    for (size_t i = 0; i < vec0.size(); ++i)
-                    {
-                        tmp_row[i] = vec0[i];
-                    }
+                    impl::convert_into(tmp_row, vec0);
 
                     return tmp_row * vec1;
                 }
             }
 
             template < typename = std::enable_if_t < is_raw_vec<tRow> &&is_raw_vec<tCol >>, typename = bool >
-            value_type eval() const
+            value_type eval(const MemoryPolicy &policy = memory_policy(), bool blas = true) const
             {
-                const int N = static_cast<int>(vec0.size());
-                return cblas_ddot(N, vec0.data(), 1, vec1.data(), 1);
+                LINEAL_COUNT(inprod_elements, vec0.size());
+                LINEAL_TRACE(inprod, vec0.size());
+
+                if constexpr(is_fixed_vec<tRow> && is_fixed_vec<tCol> &&
+                             std::is_same_v<typename tRow::value_type, typename tCol::value_type>)
+                {
+                    return impl::fixed_inprod(vec0, vec1);
+                }
+                else
+                {
+                    const KernelConfig config = with_policy(kernel_config(), policy);
+
+                    return impl::parallel_reduce<value_type>(vec0.size(), impl::chunk_size<value_type>(), [this, &config, blas](size_t begin, size_t end)
+                    {
+                        return impl::inprod_range(vec0, vec1, begin, end, config, blas);
+                    }, std::plus<value_type>());
+                }
+            }
+
+            Future<value_type> eval_async() const
+            {
+                return impl::async([row = impl::Capture<tRow>(vec0), col = impl::Capture<tCol>(vec1)]()
+                {
+                    return InProd<tRow, tCol>(row.get(), col.get()).eval();
+                });
             }
 
             operator value_type() const
@@ -177,6 +368,24 @@ auto operator*(const tRow &row, const tCol &col)
     return ::lineal::operations::InProd<tRow, tCol>(row, col).eval();
 }
 
+namespace lineal
+{
+    // `row * col` for vectors, with an explicit memory policy. BLAS ignores the policy, so this always runs the inline
+    // kernel.
+    template < typename tRow, typename tCol, std::enable_if_t < operations::valid_for_inproduct<tRow, tCol> &&
+               is_raw_vec<tRow> &&is_raw_vec<tCol>, int > = 0 >
+    auto inprod(const tRow &row, const tCol &col, const MemoryPolicy &policy)
+    {
+        return operations::InProd<tRow, tCol>(row, col).eval(policy, false);
+    }
+
+    template<typename tRow, typename tCol, std::enable_if_t<operations::valid_for_inproduct<tRow, tCol>, int> = 0>
+    auto inprod_async(const tRow &row, const tCol &col)
+    {
+        return operations::InProd<tRow, tCol>(row, col).eval_async();
+    }
+}
+
 template<typename tRow, typename tT, typename tCol, std::enable_if_t<::lineal::is_col<tCol>, int> = 0>
 auto operator*(const ::lineal::operations::VecTimesScalar<tRow, tT> &op, const tCol &col)
 {
@@ -23,3 +23,16 @@
  *
  * @endcond
  */
+#define LINEAL_BUILDING_LIBRARY
+#include "lineal/lineal.h"
+
+// Object code for the kernels listed in lineal/precompiled.h. Configuration macros such as LINEAL_ENABLE_COUNTERS
+// or LINEAL_STREAMING_THRESHOLD must match between this library and its clients; the ones that change the storage
+// layout or instrumentation are checked at link time through impl::BuildConfig.
+namespace lineal
+{
+    LINEAL_PRECOMPILED_KERNELS(template)
+
+    template<>
+    const int impl::BuildConfig::value = 1;
+}
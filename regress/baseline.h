@@ -0,0 +1,159 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace lineal
+{
+    namespace regress
+    {
+        /**
+         * Median of the repetitions with a distribution-free 95% confidence interval, taken from the order statistics
+         * around the median (normal approximation of the binomial), so single outliers do not move it.
+         */
+        struct Summary
+        {
+            double median = 0;
+            double low = 0;
+            double high = 0;
+            size_t samples = 0;
+        };
+
+        inline Summary summarise(std::vector<double> samples)
+        {
+            Summary summary;
+            summary.samples = samples.size();
+
+            if (samples.empty())
+            {
+                return summary;
+            }
+
+            std::sort(samples.begin(), samples.end());
+
+            const size_t n = samples.size();
+            const double spread = 1.96 * std::sqrt(double(n)) / 2;
+            const double centre = double(n - 1) / 2;
+
+            summary.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+            summary.low = samples[static_cast<size_t>(std::max(0.0, std::floor(centre - spread)))];
+            summary.high = samples[static_cast<size_t>(std::min(double(n - 1), std::ceil(centre + spread)))];
+
+            return summary;
+        }
+
+        /**
+         * A kernel regressed when its median slowed down by more than `threshold` and the confidence intervals of the
+         * baseline and the current run do not overlap.
+         */
+        inline bool regressed(const Summary &baseline, const Summary &current, double threshold)
+        {
+            return current.median > baseline.median * (1 + threshold) && current.low > baseline.high;
+        }
+
+        /**
+         * Baseline results, one tab separated line per machine fingerprint and benchmark:
+         *
+         *     fingerprint  benchmark  median  low  high  samples
+         *
+         * Entries of other machines are kept when the file is rewritten, so one file can be shared between hosts.
+         */
+        class BaselineFile
+        {
+        public:
+
+            using Results = std::map<std::string, Summary>;
+
+            explicit BaselineFile(std::string path)
+                : m_path(std::move(path))
+            {
+                std::ifstream in(m_path);
+                std::string line;
+
+                while (std::getline(in, line))
+                {
+                    std::istringstream fields(line);
+                    std::string fingerprint, name;
+                    Summary summary;
+
+                    if (std::getline(fields, fingerprint, '\t') && std::getline(fields, name, '\t') &&
+                            fields >> summary.median >> summary.low >> summary.high >> summary.samples)
+                    {
+                        m_machines[fingerprint][name] = summary;
+                    }
+                }
+            }
+
+            const Results *find(const std::string &fingerprint) const
+            {
+                auto it = m_machines.find(fingerprint);
+                return it == m_machines.end() ? nullptr : &it->second;
+            }
+
+            void store(const std::string &fingerprint, const Results &results)
+            {
+                m_machines[fingerprint] = results;
+            }
+
+            // Replaces only the given benchmarks of a machine and keeps its other stored results.
+            void merge(const std::string &fingerprint, const Results &results)
+            {
+                for (const auto &[name, summary] : results)
+                {
+                    m_machines[fingerprint][name] = summary;
+                }
+            }
+
+            bool save() const
+            {
+                std::ofstream out(m_path);
+                out.precision(17);
+
+                for (const auto &[fingerprint, results] : m_machines)
+                {
+                    for (const auto &[name, summary] : results)
+                    {
+                        out << fingerprint << '\t' << name << '\t' << summary.median << '\t' << summary.low << '\t'
+                            << summary.high << '\t' << summary.samples << '\n';
+                    }
+                }
+
+                return static_cast<bool>(out);
+            }
+
+        private:
+
+            std::string m_path;
+            std::map<std::string, Results> m_machines;
+        };
+    }
+}
@@ -0,0 +1,337 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "baseline.h"
+
+#include "lineal/lineal.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Regression gate over the benchmark suite in bench/. Every benchmark is repeated, summarised by its median and a
+// confidence interval, and compared against the baseline stored for this machine:
+//
+//     lineal-regress [--baseline=FILE] [--threshold=0.05] [--repetitions=10] [--update] [benchmark flags...]
+//
+// Without a stored baseline for this machine, or with --update, the results become the new baseline; with a
+// --benchmark_filter they are merged into it instead. Otherwise the exit code is 1 when any benchmark regressed by
+// more than the threshold, failed, or is in the baseline but produced no result.
+
+namespace lineal
+{
+    namespace regress
+    {
+        inline std::string cpu_model()
+        {
+            std::ifstream cpuinfo("/proc/cpuinfo");
+            std::string line;
+
+            while (std::getline(cpuinfo, line))
+            {
+                if (line.compare(0, 10, "model name") == 0)
+                {
+                    const size_t colon = line.find(':');
+                    return colon == std::string::npos ? line : line.substr(line.find_first_not_of(' ', colon + 1));
+                }
+            }
+
+            return "unknown";
+        }
+
+        constexpr const char *isa_path()
+        {
+#if SIMDPP_USE_AVX512F
+            return "avx512f";
+#elif SIMDPP_USE_AVX2
+            return "avx2";
+#elif SIMDPP_USE_AVX
+            return "avx";
+#elif SIMDPP_USE_SSE4_1
+            return "sse4.1";
+#elif SIMDPP_USE_SSE2
+            return "sse2";
+#elif SIMDPP_USE_NEON
+            return "neon";
+#else
+            return "scalar";
+#endif
+        }
+
+        // CPU model, SIMD path and BLAS backend; results are only compared between runs with the same fingerprint.
+        inline std::string fingerprint()
+        {
+            std::string result = cpu_model() + " | " + isa_path() + " | mkl " + std::to_string(INTEL_MKL_VERSION) +
+                                 " | " + std::to_string(std::thread::hardware_concurrency()) + " threads";
+
+            std::replace(result.begin(), result.end(), '\t', ' ');
+            return result;
+        }
+
+        /**
+         * Collects the per-repetition time of every benchmark. The `ns/element` counter of bench::run is preferred
+         * over the GoogleBenchmark time, as it is measured around the loop only. Benchmarks that report an error or
+         * run no iterations are collected separately.
+         */
+        class CollectingReporter : public benchmark::ConsoleReporter
+        {
+        public:
+
+            void ReportRuns(const std::vector<Run> &runs) override
+            {
+                for (const Run &run : runs)
+                {
+                    if (run.run_type != Run::RT_Iteration)
+                    {
+                        continue;
+                    }
+
+                    if (run.error_occurred || run.iterations == 0)
+                    {
+                        m_errors.insert(run.benchmark_name());
+                        continue;
+                    }
+
+                    auto counter = run.counters.find("ns/element");
+                    const double value = counter != run.counters.end() ?
+                                         static_cast<double>(counter->second) :
+                                         run.GetAdjustedRealTime() / benchmark::GetTimeUnitMultiplier(run.time_unit) * 1e9;
+
+                    m_samples[run.benchmark_name()].push_back(value);
+                }
+
+                benchmark::ConsoleReporter::ReportRuns(runs);
+            }
+
+            BaselineFile::Results results() const
+            {
+                BaselineFile::Results results;
+
+                for (const auto &[name, samples] : m_samples)
+                {
+                    if (m_errors.count(name) == 0)
+                    {
+                        results[name] = summarise(samples);
+                    }
+                }
+
+                return results;
+            }
+
+            const std::set<std::string> &errors() const
+            {
+                return m_errors;
+            }
+
+        private:
+
+            std::map<std::string, std::vector<double>> m_samples;
+            std::set<std::string> m_errors;
+        };
+
+        inline bool parse_flag(const char *arg, const char *name, std::string &value)
+        {
+            const size_t length = std::strlen(name);
+
+            if (std::strncmp(arg, name, length) == 0 && arg[length] == '=')
+            {
+                value = arg + length + 1;
+                return true;
+            }
+
+            return false;
+        }
+
+        // Whether `--benchmark_filter` selects `name`; a leading '-' negates the filter, as in GoogleBenchmark.
+        inline bool selected(const std::string &name, const std::string &filter)
+        {
+            if (filter.empty() || filter == "all")
+            {
+                return true;
+            }
+
+            if (filter[0] == '-')
+            {
+                return !std::regex_search(name, std::regex(filter.substr(1)));
+            }
+
+            return std::regex_search(name, std::regex(filter));
+        }
+
+        inline void print_failures(const std::set<std::string> &errors)
+        {
+            for (const std::string &name : errors)
+            {
+                std::cout << std::left << std::setw(56) << name << std::right << std::setw(14) << "-"
+                          << std::setw(14) << "-" << std::setw(10) << "-" << "  ERROR\n";
+            }
+        }
+
+        /**
+         * Prints the comparison table and returns the number of failures: regressions, errored benchmarks, and baseline
+         * entries selected by `filter` that produced no result.
+         */
+        inline size_t compare(const BaselineFile::Results &baseline, const BaselineFile::Results &current,
+                              const std::set<std::string> &errors, const std::string &filter, double threshold)
+        {
+            size_t regressions = 0;
+
+            std::cout << '\n' << std::left << std::setw(56) << "benchmark" << std::right << std::setw(14) << "baseline"
+                      << std::setw(14) << "current" << std::setw(10) << "change" << "  status\n";
+
+            for (const auto &[name, summary] : current)
+            {
+                auto it = baseline.find(name);
+
+                if (it == baseline.end())
+                {
+                    std::cout << std::left << std::setw(56) << name << std::right << std::setw(14) << "-"
+                              << std::setw(14) << summary.median << std::setw(10) << "-" << "  new\n";
+                    continue;
+                }
+
+                const bool slower = regressed(it->second, summary, threshold);
+                regressions += slower;
+
+                std::cout << std::left << std::setw(56) << name << std::right << std::setw(14) << it->second.median
+                          << std::setw(14) << summary.median << std::setw(9) << std::fixed << std::setprecision(1)
+                          << 100 * (summary.median / it->second.median - 1) << "%" << std::defaultfloat
+                          << std::setprecision(6) << (slower ? "  REGRESSED\n" : "  ok\n");
+            }
+
+            print_failures(errors);
+            regressions += errors.size();
+
+            for (const auto &[name, summary] : baseline)
+            {
+                if (current.count(name) == 0 && errors.count(name) == 0 && selected(name, filter))
+                {
+                    std::cout << std::left << std::setw(56) << name << std::right << std::setw(14) << summary.median
+                              << std::setw(14) << "-" << std::setw(10) << "-" << "  MISSING\n";
+                    ++regressions;
+                }
+            }
+
+            return regressions;
+        }
+    }
+}
+
+int main(int argc, char **argv)
+{
+    using namespace lineal::regress;
+
+    std::string path = "lineal-baseline.tsv";
+    std::string threshold = "0.05";
+    std::string repetitions = "10";
+    std::string filter;
+    bool update = false;
+
+    std::vector<char *> args = { argv[0] };
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--update") == 0)
+        {
+            update = true;
+        }
+        else if (!parse_flag(argv[i], "--baseline", path) && !parse_flag(argv[i], "--threshold", threshold) &&
+                 !parse_flag(argv[i], "--repetitions", repetitions))
+        {
+            parse_flag(argv[i], "--benchmark_filter", filter);
+            args.push_back(argv[i]);
+        }
+    }
+
+    std::string repetitions_flag = "--benchmark_repetitions=" + repetitions;
+    args.push_back(repetitions_flag.data());
+
+    int count = static_cast<int>(args.size());
+    benchmark::Initialize(&count, args.data());
+
+    if (benchmark::ReportUnrecognizedArguments(count, args.data()))
+    {
+        return 2;
+    }
+
+    CollectingReporter reporter;
+    benchmark::RunSpecifiedBenchmarks(&reporter);
+
+    const std::string machine = fingerprint();
+    const BaselineFile::Results current = reporter.results();
+    BaselineFile baseline(path);
+
+    std::cout << "\nmachine: " << machine << '\n';
+
+    if (update || !baseline.find(machine))
+    {
+        // A filtered run only measured part of the suite, so it must not drop the other stored results.
+        if (filter.empty())
+        {
+            baseline.store(machine, current);
+        }
+        else
+        {
+            baseline.merge(machine, current);
+        }
+
+        if (!baseline.save())
+        {
+            std::cerr << "could not write baseline " << path << '\n';
+            return 2;
+        }
+
+        std::cout << "stored " << current.size() << " results as baseline in " << path << '\n';
+
+        if (!reporter.errors().empty())
+        {
+            std::cout << '\n';
+            print_failures(reporter.errors());
+            std::cout << '\n' << reporter.errors().size() << " benchmark(s) failed and were not stored\n";
+            return 1;
+        }
+
+        return 0;
+    }
+
+    const size_t failures = compare(*baseline.find(machine), current, reporter.errors(), filter, std::stod(threshold));
+
+    if (failures != 0)
+    {
+        std::cout << '\n' << failures << " benchmark(s) regressed beyond " << threshold << ", failed or are missing\n";
+        return 1;
+    }
+
+    return 0;
+}
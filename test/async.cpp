@@ -0,0 +1,131 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+
+namespace
+{
+    const size_t n = 4097;
+
+    template<typename tVec>
+    void iota(tVec &v)
+    {
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            v[i] = 0.5 * double(i);
+        }
+    }
+
+    // Builds the futures in a frame of their own, so the expression temporaries are gone before the results are read.
+    lineal::Future<double> nested_inprod(const lineal::Row<double> &row, const lineal::Col<double> &col)
+    {
+        return lineal::inprod_async(lineal::sqrt(row + 1.0) * 2.0 - 3.0, (lineal::abs(col) * 0.5 + 1.0) / 4.0);
+    }
+
+    lineal::Future<double> nested_sum(const lineal::Col<double> &col)
+    {
+        return lineal::sum_async(1.0 - 2.0 / (lineal::sqrt(col) + 10.0));
+    }
+
+    lineal::Future<void> nested_assign(lineal::Col<double> &out, const lineal::Col<double> &col)
+    {
+        return out.assign_async((lineal::abs(col) * 2.0 + 1.0) * 3.0 - 2.0);
+    }
+
+    lineal::Future<double> transposed_inprod(const lineal::Row<double> &row, const lineal::Col<double> &col)
+    {
+        return lineal::inprod_async(lineal::t(lineal::sqrt(col) * 2.0 + 1.0), lineal::t(lineal::abs(row) - 1.0) * 0.5);
+    }
+
+    // Overwrites the stack where the temporaries lived.
+    double scribble()
+    {
+        volatile double junk[512];
+
+        for (size_t i = 0; i < 512; ++i)
+        {
+            junk[i] = -1e300;
+        }
+
+        return junk[0];
+    }
+}
+
+TEST(Async, NestedExpressionsOutliveTemporaries)
+{
+    lineal::Row<double> row(n);
+    lineal::Col<double> col(n);
+    lineal::Col<double> out(n);
+    iota(row);
+    iota(col);
+
+    lineal::Future<double> dot = nested_inprod(row, col);
+    lineal::Future<double> total = nested_sum(col);
+    lineal::Future<void> assigned = nested_assign(out, col);
+    scribble();
+
+    double expected_dot = 0.0;
+    double expected_total = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        expected_dot += (std::sqrt(row[i] + 1.0) * 2.0 - 3.0) * ((col[i] * 0.5 + 1.0) / 4.0);
+        expected_total += 1.0 - 2.0 / (std::sqrt(col[i]) + 10.0);
+    }
+
+    EXPECT_NEAR(dot.get(), expected_dot, 1e-9 * expected_dot);
+    EXPECT_NEAR(total.get(), expected_total, 1e-9 * expected_total);
+    assigned.get();
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        ASSERT_DOUBLE_EQ(out[i], (col[i] * 2.0 + 1.0) * 3.0 - 2.0);
+    }
+}
+
+TEST(Async, TransposedExpressionsOutliveTemporaries)
+{
+    lineal::Row<double> row(n);
+    lineal::Col<double> col(n);
+    iota(row);
+    iota(col);
+
+    lineal::Future<double> dot = transposed_inprod(row, col);
+    scribble();
+
+    double expected = 0.0;
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        expected += (std::sqrt(col[i]) * 2.0 + 1.0) * ((std::abs(row[i]) - 1.0) * 0.5);
+    }
+
+    EXPECT_NEAR(dot.get(), expected, 1e-9 * std::abs(expected));
+}
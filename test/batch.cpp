@@ -0,0 +1,102 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace
+{
+    // Builds `count` pairs whose lengths differ and cover the register tail, so groups mix short and long pairs.
+    template<typename tT>
+    void expect_matches_reference(size_t count, size_t max_length, double tolerance)
+    {
+        std::vector<std::unique_ptr<lineal::Row<tT>>> rows;
+        std::vector<std::unique_ptr<lineal::Col<tT>>> cols;
+        std::vector<const lineal::Row<tT> *> row_ptrs;
+        std::vector<const lineal::Col<tT> *> col_ptrs;
+
+        for (size_t p = 0; p < count; ++p)
+        {
+            const size_t n = (p * 37) % max_length;
+            rows.emplace_back(std::make_unique<lineal::Row<tT>>(n));
+            cols.emplace_back(std::make_unique<lineal::Col<tT>>(n));
+
+            for (size_t i = 0; i < n; ++i)
+            {
+                (*rows.back())[i] = tT(double(i % 7) - 3.0);
+                (*cols.back())[i] = tT(0.25 * double((p + i) % 29));
+            }
+
+            row_ptrs.push_back(rows.back().get());
+            col_ptrs.push_back(cols.back().get());
+        }
+
+        std::vector<tT> results(count);
+        lineal::inprod_batch(row_ptrs.data(), col_ptrs.data(), count, results.data());
+
+        for (size_t p = 0; p < count; ++p)
+        {
+            double expected = 0.0;
+
+            for (size_t i = 0; i < rows[p]->size(); ++i)
+            {
+                expected += double((*rows[p])[i]) * double((*cols[p])[i]);
+            }
+
+            EXPECT_NEAR(results[p], expected, tolerance * (1.0 + std::abs(expected))) << "pair " << p;
+        }
+    }
+}
+
+TEST(Batch, MatchesScalarReference)
+{
+    expect_matches_reference<double>(37, 101, 1e-9);
+}
+
+TEST(Batch, MatchesScalarReferenceFloat)
+{
+    expect_matches_reference<float>(37, 101, 1e-5);
+}
+
+TEST(Batch, ParallelChunks)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    const size_t threads = lineal::get_num_threads();
+
+    // More pairs than one chunk of LINEAL_BATCH_GRAIN, with a threshold low enough to hand the chunks to the pool.
+    lineal::set_parallel_threshold(1024);
+    lineal::set_num_threads(4);
+
+    expect_matches_reference<double>(3 * LINEAL_BATCH_GRAIN + 5, 67, 1e-9);
+
+    lineal::set_num_threads(threads);
+    lineal::set_parallel_threshold(threshold);
+}
@@ -0,0 +1,215 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace
+{
+    // Sizes around the register width, including tails that do not fill a register, and the parallel threshold.
+    const std::vector<size_t> sizes = {0, 1, 3, 4, 7, 8, 15, 33, 64, 127, 1001, 100003};
+
+    template<typename tVec>
+    void iota(tVec &v, double scale = 0.5)
+    {
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            v[i] = static_cast<typename tVec::value_type>(double(i % 17) * scale - 3.0);
+        }
+    }
+
+    // Evaluates `op` through the packed assignment loop.
+    template<typename tT, typename tOp>
+    lineal::Row<tT> evaluate(const tOp &op)
+    {
+        lineal::Row<tT> out(op.size());
+        out = op;
+        return out;
+    }
+
+    // Evaluates a mask through the packed loop as ones where it is set and zeros elsewhere.
+    template<typename tMask, typename tVec>
+    lineal::Row<typename tVec::value_type> evaluate_mask(const tMask &mask, const tVec &ones)
+    {
+        return evaluate<typename tVec::value_type>(lineal::where(mask, ones, 0));
+    }
+}
+
+TEST(Compare, MinMaxClamp)
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> a(n);
+        lineal::Row<double> b(n);
+        lineal::Row<double> lo(n, lineal::fill::zeros);
+        lineal::Row<double> hi(n, lineal::fill::ones);
+        iota(a);
+        iota(b, -0.25);
+
+        for (size_t i = 0; i < n; i += 5)
+        {
+            a[i] = nan;
+        }
+
+        const auto low = evaluate<double>(lineal::min(b, a));
+        const auto high = evaluate<double>(lineal::max(b, 0.5));
+        const auto lowest = evaluate<double>(lineal::min(-1.0, b * 2.0));
+        const auto clamped = evaluate<double>(lineal::clamp(a, -1.0, 2.0));
+        const auto bounded = evaluate<double>(lineal::clamp(a, lo, hi));
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(high[i], std::max(b[i], 0.5)) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(lowest[i], std::min(-1.0, b[i] * 2.0)) << "n = " << n << ", i = " << i;
+
+            // A NaN operand gives the second one, so clamp maps NaN to its lower bound.
+            if (std::isnan(a[i]))
+            {
+                EXPECT_TRUE(std::isnan(low[i])) << "n = " << n << ", i = " << i;
+                EXPECT_EQ(clamped[i], -1.0) << "n = " << n << ", i = " << i;
+                EXPECT_EQ(bounded[i], 0.0) << "n = " << n << ", i = " << i;
+            }
+            else
+            {
+                EXPECT_EQ(low[i], std::min(b[i], a[i])) << "n = " << n << ", i = " << i;
+                EXPECT_EQ(clamped[i], std::min(std::max(a[i], -1.0), 2.0)) << "n = " << n << ", i = " << i;
+                EXPECT_EQ(bounded[i], std::min(std::max(a[i], 0.0), 1.0)) << "n = " << n << ", i = " << i;
+            }
+        }
+    }
+}
+
+TEST(Compare, IntegerElements)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<int32_t> a(n);
+        iota(a, 3.0);
+
+        const auto high = evaluate<int32_t>(lineal::max(a, 0));
+        const auto magnitude = evaluate<int32_t>(lineal::abs(a));
+        const auto clamped = evaluate<int32_t>(lineal::clamp(a, -2, 5));
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(high[i], std::max(a[i], 0)) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(magnitude[i], std::abs(a[i])) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(clamped[i], std::min(std::max(a[i], -2), 5)) << "n = " << n << ", i = " << i;
+        }
+    }
+}
+
+TEST(Compare, Comparisons)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Col<float> a(n);
+        lineal::Col<float> b(n);
+        lineal::Col<float> ones(n, lineal::fill::ones);
+        iota(a);
+        iota(b, 0.25);
+
+        const auto lt = evaluate_mask(a < b, ones);
+        const auto le = evaluate_mask(a <= b, ones);
+        const auto gt = evaluate_mask(a > 0.0f, ones);
+        const auto ge = evaluate_mask(1.0f >= a, ones);
+        const auto eq = evaluate_mask(a == b, ones);
+        const auto ne = evaluate_mask(a != b * 1.0f, ones);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            // The scalar element access of a mask agrees with its packed form.
+            EXPECT_EQ((a < b)[i], a[i] < b[i]);
+
+            EXPECT_EQ(lt[i], a[i] < b[i] ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(le[i], a[i] <= b[i] ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(gt[i], a[i] > 0.0f ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(ge[i], 1.0f >= a[i] ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(eq[i], a[i] == b[i] ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(ne[i], a[i] != b[i] ? 1.0f : 0.0f) << "n = " << n << ", i = " << i;
+        }
+    }
+}
+
+TEST(Compare, MaskLogic)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> a(n);
+        lineal::Row<double> ones(n, lineal::fill::ones);
+        iota(a);
+
+        const auto inside = evaluate_mask((a > -1.0) & (a < 1.0), ones);
+        const auto outside = evaluate_mask((a < -1.0) | (a > 1.0), ones);
+        const auto negated = evaluate_mask(!(a > 0.0), ones);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(inside[i], a[i] > -1.0 && a[i] < 1.0 ? 1.0 : 0.0) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(outside[i], a[i] < -1.0 || a[i] > 1.0 ? 1.0 : 0.0) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(negated[i], a[i] > 0.0 ? 0.0 : 1.0) << "n = " << n << ", i = " << i;
+        }
+    }
+}
+
+TEST(Compare, WhereAndSelect)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> a(n);
+        lineal::Row<double> b(n);
+        iota(a);
+        iota(b, -1.0);
+
+        const auto on_vec = evaluate<double>(lineal::where(a > 0.0, a, -1.0));
+        const auto off_vec = evaluate<double>(lineal::where(a > 0.0, -1.0, b * 2.0));
+        const auto both = evaluate<double>(lineal::select(a > b, a, b));
+        const auto masked = evaluate<double>(lineal::where(a > 0.0, a));
+
+        double positive = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            EXPECT_EQ(on_vec[i], a[i] > 0.0 ? a[i] : -1.0) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(off_vec[i], a[i] > 0.0 ? -1.0 : b[i] * 2.0) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(both[i], std::max(a[i], b[i])) << "n = " << n << ", i = " << i;
+            EXPECT_EQ(masked[i], a[i] > 0.0 ? a[i] : 0.0) << "n = " << n << ", i = " << i;
+
+            positive += a[i] > 0.0 ? a[i] : 0.0;
+        }
+
+        EXPECT_NEAR(lineal::sum(lineal::where(a > 0.0, a)), positive, 1e-9 * (1 + positive)) << "n = " << n;
+    }
+}
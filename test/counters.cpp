@@ -0,0 +1,112 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+
+// The test target is built with counters enabled (see zpm.lua); without them every count below would stay zero.
+#if !defined(LINEAL_ENABLE_COUNTERS)
+#error "the tests expect LINEAL_ENABLE_COUNTERS"
+#endif
+
+TEST(Counters, Allocations)
+{
+    lineal::reset_counters();
+
+    {
+        lineal::Row<double> a(1000, lineal::fill::ones);
+
+        EXPECT_EQ(lineal::counters()[lineal::Counter::allocations], 1u);
+        EXPECT_GE(lineal::counters()[lineal::Counter::allocated_bytes], 1000 * sizeof(double));
+        EXPECT_EQ(lineal::counters()[lineal::Counter::frees], 0u);
+    }
+
+    EXPECT_EQ(lineal::counters()[lineal::Counter::frees], 1u);
+}
+
+TEST(Counters, Kernels)
+{
+    const size_t n = 100003;
+
+    lineal::Row<double> row(n, lineal::fill::ones);
+    lineal::Col<double> col(n, lineal::fill::ones);
+
+    lineal::reset_counters();
+
+    row = row * 2.0;
+    EXPECT_EQ(lineal::counters()[lineal::Counter::assign_elements], n);
+
+    EXPECT_EQ(lineal::sum(row), 2.0 * n);
+    EXPECT_EQ(lineal::counters()[lineal::Counter::sum_elements], n);
+
+    EXPECT_EQ(row * col, 2.0 * n);
+    EXPECT_EQ(lineal::counters()[lineal::Counter::inprod_elements], n);
+    EXPECT_GT(lineal::counters()[lineal::Counter::blas_calls] + lineal::counters()[lineal::Counter::inline_calls], 0u);
+
+    // A memory policy keeps the product on the inline kernel.
+    const lineal::CounterSnapshot before = lineal::counters();
+
+    EXPECT_EQ(lineal::inprod(row, col, lineal::MemoryPolicy::streaming()), 2.0 * n);
+    EXPECT_EQ(lineal::counters()[lineal::Counter::blas_calls], before[lineal::Counter::blas_calls]);
+    EXPECT_GT(lineal::counters()[lineal::Counter::inline_calls], before[lineal::Counter::inline_calls]);
+}
+
+TEST(Counters, CountsOnWorkers)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    const size_t threads = lineal::get_num_threads();
+    const size_t n = 1 << 18;
+
+    lineal::set_parallel_threshold(1024);
+    lineal::set_num_threads(4);
+
+    lineal::Row<double> row(n, lineal::fill::ones);
+    lineal::Col<double> col(n, lineal::fill::ones);
+
+    lineal::reset_counters();
+    EXPECT_EQ(row * col, double(n));
+
+    // Every chunk picks its kernel on the thread that runs it.
+    const auto calls = [&]()
+    {
+        const lineal::CounterSnapshot snapshot = lineal::counters();
+        return snapshot[lineal::Counter::blas_calls] + snapshot[lineal::Counter::inline_calls];
+    };
+
+    const uint64_t chunks = calls();
+    EXPECT_GT(chunks, 1u);
+
+    // Counts of workers are kept after their pool is replaced and the threads exit.
+    lineal::set_num_threads(2);
+    EXPECT_EQ(row * col, double(n));
+    EXPECT_EQ(calls(), 2 * chunks);
+
+    lineal::set_num_threads(threads);
+    lineal::set_parallel_threshold(threshold);
+}
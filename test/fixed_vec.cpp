@@ -0,0 +1,77 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <vector>
+
+TEST(FixedVec, InProdAndSum)
+{
+    lineal::FixedRow<double, 13> row;
+    lineal::FixedCol<double, 13> col;
+
+    double dot = 0.0;
+    double total = 0.0;
+
+    for (size_t i = 0; i < 13; ++i)
+    {
+        row[i] = double(i) - 4.0;
+        col[i] = 0.5 * double(i);
+        dot += row[i] * col[i];
+        total += row[i];
+    }
+
+    EXPECT_DOUBLE_EQ(row * col, dot);
+    EXPECT_DOUBLE_EQ(lineal::sum(row), total);
+}
+
+TEST(FixedVec, UnalignedViews)
+{
+    // Views one element past an aligned boundary cannot use aligned loads.
+    std::vector<double> buffer(64);
+
+    for (size_t i = 0; i < buffer.size(); ++i)
+    {
+        buffer[i] = double(i % 11) - 5.0;
+    }
+
+    lineal::ConstFixedRow<double, 17> row(buffer.data() + 1);
+    lineal::ConstFixedCol<double, 17> col(buffer.data() + 33);
+
+    double dot = 0.0;
+    double total = 0.0;
+
+    for (size_t i = 0; i < 17; ++i)
+    {
+        dot += buffer[1 + i] * buffer[33 + i];
+        total += buffer[1 + i];
+    }
+
+    EXPECT_DOUBLE_EQ(row * col, dot);
+    EXPECT_DOUBLE_EQ(lineal::sum(row), total);
+}
@@ -0,0 +1,74 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+
+TEST(Fused, MatchesSeparateEvaluation)
+{
+    for (size_t n : {size_t(0), size_t(3), size_t(64), size_t(1001), size_t(300001)})
+    {
+        lineal::Row<double> a(n);
+        lineal::Row<double> b(n);
+        lineal::Row<double> r1(n);
+        lineal::Row<double> r2(n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = 0.25 * double(i % 97);
+            b[i] = 1.0 + double(i % 13);
+        }
+
+        double s = 0.0;
+        lineal::fused(lineal::assign_to(r1, a * 2.0 + 1.0), lineal::assign_to(r2, lineal::max(a, b) * 0.5), lineal::sum_into(s, a));
+
+        double expected = 0.0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_DOUBLE_EQ(r1[i], a[i] * 2.0 + 1.0);
+            ASSERT_DOUBLE_EQ(r2[i], std::max(a[i], b[i]) * 0.5);
+            expected += a[i];
+        }
+
+        EXPECT_NEAR(s, expected, 1e-9 * (1.0 + expected)) << "n = " << n;
+    }
+}
+
+#ifndef NDEBUG
+TEST(FusedDeathTest, UnequalSizes)
+{
+    lineal::Row<double> a(16);
+    lineal::Row<double> b(8);
+    lineal::Row<double> r(16);
+    double s = 0.0;
+
+    EXPECT_DEATH(lineal::fused(lineal::assign_to(r, a * 2.0), lineal::sum_into(s, b)), "equal sizes");
+}
+#endif
@@ -23,79 +23,10 @@
  *
  * @endcond
  */
-#include "lineal/lineal.h"
+#include <gtest/gtest.h>
 
-#include <armadillo>
-
-#include <cstdlib>
-#include <iostream>
-#include <chrono>
-
-template<typename tRow, typename tCol>
-void bench_op(const tRow &row, const tCol &col)
+int main(int argc, char **argv)
 {
-    auto row_op = (row * 2.0) / 3.0;
-    auto col_op = col * 2.0;
-
-    auto start = std::chrono::high_resolution_clock::now();
-
-    double alpha = 0.0;
-
-    constexpr size_t iterations = 2000000;
-
-    std::cout << lineal::is_scalar_addition<decltype(col_op)> << std::endl;
-
-    for (size_t i = 0; i < iterations; ++i)
-    {
-        alpha += arma::as_scalar(row_op * col_op);
-
-    }
-
-    auto end = std::chrono::high_resolution_clock::now();
-    std::cout << alpha << std::endl;
-    std::cout << "Took "
-              << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1.0 / iterations
-              << "ns per dot-product" << std::endl;
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
 }
-
-void main(int argc, char **argv)
-{
-    {
-        lineal::Row<double> row(1024, lineal::fill::ones);
-        lineal::Col<double> col(1024, lineal::fill::ones);
-        lineal::ConstCol<double> const_col(col.begin(), col.size());
-
-        bench_op(row, const_col);
-    }
-    {
-        arma::rowvec row(1024, arma::fill::ones);
-        arma::vec col(1024, arma::fill::ones);
-        bench_op(row, col);
-    }
-    // system("pause");
-    //     auto row_op0 = 1.0 / (4.0 + row + 3.0);
-    //     auto row_op = 2.0 / row_op0;
-    //     auto col_op = (5.0 - (col + 2.0) - 1.0) * 2.0;
-
-    //     auto row_op = row + 2.0;
-    //     auto col_op = const_col / 2.0;
-    //
-    //     auto start = std::chrono::high_resolution_clock::now();
-    //
-    //     double alpha = 0.0;
-    //
-    //     constexpr size_t iterations = 2000000;
-    //
-    //     std::cout << lineal::is_scalar_addition<decltype(col_op)> << std::endl;
-    //
-    //     for (size_t i = 0; i < iterations; ++i)
-    //     {
-    //         alpha += row_op * col_op;
-    //     }
-    //
-    //     auto end = std::chrono::high_resolution_clock::now();
-    //     std::cout << alpha << std::endl;
-    //     std::cout << "Took "
-    //               << std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count() * 1.0 / iterations
-    //               << "ns per dot-product" << std::endl;
-}
\ No newline at end of file
@@ -0,0 +1,270 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Evaluates `func` through the packed loops; every input is repeated so it also lands on full registers.
+    template<typename tT, typename tFunc>
+    std::vector<tT> evaluate(const std::vector<tT> &inputs, const tFunc &func)
+    {
+        constexpr size_t repeats = 16;
+
+        lineal::Col<tT> x(inputs.size() * repeats);
+        lineal::Col<tT> y(inputs.size() * repeats);
+
+        for (size_t i = 0; i < x.size(); ++i)
+        {
+            x[i] = inputs[i % inputs.size()];
+        }
+
+        y = func(x);
+
+        return std::vector<tT>(y.data(), y.data() + inputs.size());
+    }
+
+    // Distance between `value` and the exact `reference` in units of the last place of tT at the reference.
+    template<typename tT>
+    double ulp_error(tT value, long double reference)
+    {
+        const tT rounded = static_cast<tT>(reference);
+        const tT magnitude = std::abs(rounded);
+        const tT ulp = std::nextafter(magnitude, std::numeric_limits<tT>::infinity()) - magnitude;
+
+        return static_cast<double>(std::abs(static_cast<long double>(value) - reference) / ulp);
+    }
+
+    // Inputs spread over [low, high], plus `extra` values such as range boundaries.
+    template<typename tT>
+    std::vector<tT> uniform(tT low, tT high, std::vector<tT> extra = {})
+    {
+        std::mt19937 engine(42);
+        std::uniform_real_distribution<long double> distribution(low, high);
+
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            extra.push_back(static_cast<tT>(distribution(engine)));
+        }
+
+        return extra;
+    }
+
+    // Positive inputs with uniformly spread exponents between the smallest normal number and the largest finite one.
+    template<typename tT>
+    std::vector<tT> positive_normals()
+    {
+        std::mt19937 engine(7);
+        std::uniform_real_distribution<long double> mantissa(1, 2);
+        std::uniform_int_distribution<int> exponent(std::numeric_limits<tT>::min_exponent - 1,
+                std::numeric_limits<tT>::max_exponent - 1);
+
+        std::vector<tT> inputs = {std::numeric_limits<tT>::min(), std::numeric_limits<tT>::max(), tT(1),
+                                  std::nextafter(tT(1), tT(0)), std::nextafter(tT(1), tT(2))
+                                 };
+
+        for (size_t i = 0; i < 20000; ++i)
+        {
+            inputs.push_back(static_cast<tT>(std::ldexp(mantissa(engine), exponent(engine))));
+        }
+
+        return inputs;
+    }
+
+    template<typename tT, typename tFunc, typename tReference>
+    double max_ulp_error(const std::vector<tT> &inputs, const tFunc &func, const tReference &reference)
+    {
+        const std::vector<tT> results = evaluate(inputs, func);
+        double worst = 0;
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            const double error = ulp_error(results[i], reference(static_cast<long double>(inputs[i])));
+            EXPECT_FALSE(std::isnan(error)) << "x = " << inputs[i];
+            worst = std::max(worst, error);
+        }
+
+        return worst;
+    }
+
+    // Checks special inputs bit for bit, including the sign of zero; NaN only has to come out as some NaN.
+    template<typename tT, typename tFunc>
+    void expect_special(const std::vector<tT> &inputs, const std::vector<tT> &expected, const tFunc &func)
+    {
+        const std::vector<tT> results = evaluate(inputs, func);
+
+        for (size_t i = 0; i < inputs.size(); ++i)
+        {
+            if (std::isnan(expected[i]))
+            {
+                EXPECT_TRUE(std::isnan(results[i])) << "x = " << inputs[i];
+            }
+            else
+            {
+                EXPECT_EQ(results[i], expected[i]) << "x = " << inputs[i];
+                EXPECT_EQ(std::signbit(results[i]), std::signbit(expected[i])) << "x = " << inputs[i];
+            }
+        }
+    }
+
+    template<typename tT>
+    class Math : public ::testing::Test
+    {
+    };
+
+    using MathTypes = ::testing::Types<float, double>;
+
+    const auto exp_func = [](const auto &x)
+    {
+        return lineal::exp(x);
+    };
+
+    const auto log_func = [](const auto &x)
+    {
+        return lineal::log(x);
+    };
+
+    const auto rsqrt_func = [](const auto &x)
+    {
+        return lineal::rsqrt(x);
+    };
+
+    const auto tanh_func = [](const auto &x)
+    {
+        return lineal::tanh(x);
+    };
+
+    const auto sigmoid_func = [](const auto &x)
+    {
+        return lineal::sigmoid(x);
+    };
+}
+
+TYPED_TEST_SUITE(Math, MathTypes);
+
+TYPED_TEST(Math, Exp)
+{
+    using tT = TypeParam;
+    using tTraits = lineal::impl::MathTraits<tT>;
+
+    const tT inf = std::numeric_limits<tT>::infinity();
+    const tT nan = std::numeric_limits<tT>::quiet_NaN();
+
+    const std::vector<tT> inputs = uniform<tT>(tTraits::exp_min, tTraits::exp_max,
+    {
+        tTraits::exp_min, tTraits::exp_max, tT(-1e-30), tT(1e-30), tT(0.5), tT(-0.5)
+    });
+
+    EXPECT_LE(max_ulp_error(inputs, exp_func, [](long double x)
+    {
+        return std::exp(x);
+    }), 1.5);
+
+    // Below exp_min the result would be denormal and flushes to zero; above exp_max it overflows to infinity.
+    expect_special<tT>({tT(0), tT(-0.0), inf, -inf, nan, std::nextafter(tTraits::exp_min, -inf), std::nextafter(tTraits::exp_max, inf)},
+                       {tT(1), tT(1), inf, tT(0), nan, tT(0), inf}, exp_func);
+    EXPECT_GT(evaluate<tT>({tTraits::exp_min}, exp_func)[0], tT(0));
+}
+
+TYPED_TEST(Math, Log)
+{
+    using tT = TypeParam;
+
+    const tT inf = std::numeric_limits<tT>::infinity();
+    const tT nan = std::numeric_limits<tT>::quiet_NaN();
+
+    EXPECT_LE(max_ulp_error(positive_normals<tT>(), log_func, [](long double x)
+    {
+        return std::log(x);
+    }), 1.0);
+
+    expect_special<tT>({tT(0), tT(-0.0), tT(1), tT(-1), -inf, inf, nan},
+                       {-inf, -inf, tT(0), nan, nan, inf, nan}, log_func);
+}
+
+TYPED_TEST(Math, Rsqrt)
+{
+    using tT = TypeParam;
+
+    const tT inf = std::numeric_limits<tT>::infinity();
+    const tT nan = std::numeric_limits<tT>::quiet_NaN();
+
+    EXPECT_LE(max_ulp_error(positive_normals<tT>(), rsqrt_func, [](long double x)
+    {
+        return 1 / std::sqrt(x);
+    }), 1.5);
+
+    expect_special<tT>({tT(0), tT(-0.0), tT(1), tT(4), tT(-1), inf, nan},
+                       {inf, -inf, tT(1), tT(0.5), nan, tT(0), nan}, rsqrt_func);
+}
+
+TYPED_TEST(Math, Tanh)
+{
+    using tT = TypeParam;
+
+    const tT inf = std::numeric_limits<tT>::infinity();
+    const tT nan = std::numeric_limits<tT>::quiet_NaN();
+
+    const std::vector<tT> inputs = uniform<tT>(tT(-20), tT(20),
+    {
+        tT(1e-30), tT(-1e-30), tT(1e-5), tT(-1e-5), std::numeric_limits<tT>::min(), tT(0.5), tT(-0.5)
+    });
+
+    EXPECT_LE(max_ulp_error(inputs, tanh_func, [](long double x)
+    {
+        return std::tanh(x);
+    }), 3.0);
+
+    expect_special<tT>({tT(0), tT(-0.0), inf, -inf, tT(1000), tT(-1000), nan},
+                       {tT(0), tT(-0.0), tT(1), tT(-1), tT(1), tT(-1), nan}, tanh_func);
+}
+
+TYPED_TEST(Math, Sigmoid)
+{
+    using tT = TypeParam;
+    using tTraits = lineal::impl::MathTraits<tT>;
+
+    const tT inf = std::numeric_limits<tT>::infinity();
+    const tT nan = std::numeric_limits<tT>::quiet_NaN();
+
+    // Below -exp_max exp(-x) overflows and the result saturates to zero.
+    const std::vector<tT> inputs = uniform<tT>(-tTraits::exp_max, tT(40), {-tTraits::exp_max, tT(0), tT(1e-30), tT(-1e-30)});
+
+    EXPECT_LE(max_ulp_error(inputs, sigmoid_func, [](long double x)
+    {
+        return 1 / (1 + std::exp(-x));
+    }), 3.0);
+
+    expect_special<tT>({tT(0), tT(-0.0), inf, -inf, std::nextafter(-tTraits::exp_max, -inf), tT(1000), nan},
+                       {tT(0.5), tT(0.5), tT(1), tT(0), tT(0), tT(1), nan}, sigmoid_func);
+}
@@ -0,0 +1,177 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+
+namespace
+{
+    // Forwards to the default resource and records what passes through it.
+    class CountingResource : public std::pmr::memory_resource
+    {
+    public:
+
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t outstanding = 0;
+        size_t alignment = 0;
+
+    private:
+
+        void *do_allocate(size_t bytes, size_t align) override
+        {
+            ++allocations;
+            outstanding += bytes;
+            alignment = align;
+            return std::pmr::new_delete_resource()->allocate(bytes, align);
+        }
+
+        void do_deallocate(void *p, size_t bytes, size_t align) override
+        {
+            ++deallocations;
+            outstanding -= bytes;
+            std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+        }
+
+        bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+        {
+            return this == &other;
+        }
+    };
+}
+
+#if LINEAL_SMALL_BUFFER_BYTES == 0
+static_assert(sizeof(lineal::Row<double>) <= 64, "vectors without a small buffer stay within a cache line");
+#endif
+
+TEST(Memory, MoveKeepsContents)
+{
+    for (size_t n : {size_t(0), size_t(1), size_t(7), size_t(64), size_t(1000)})
+    {
+        lineal::Row<double> a(n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            a[i] = double(i);
+        }
+
+        lineal::Row<double> b(std::move(a));
+        lineal::Row<double> c;
+        c = std::move(b);
+
+        ASSERT_EQ(c.size(), n);
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_EQ(c[i], double(i));
+        }
+    }
+}
+
+TEST(Memory, ShareIsolatesWrites)
+{
+    lineal::Row<double> a(100, lineal::fill::ones);
+    lineal::Row<double> b = lineal::share(a);
+
+#if defined(LINEAL_COPY_ON_WRITE)
+    EXPECT_EQ(a.data(), b.data());
+#else
+    EXPECT_NE(a.data(), b.data());
+#endif
+
+    b[0] = 5.0;
+
+    EXPECT_EQ(a[0], 1.0);
+    EXPECT_EQ(b[0], 5.0);
+    EXPECT_EQ(b[99], 1.0);
+}
+
+TEST(Memory, PaddedStorage)
+{
+    constexpr size_t count = lineal::impl::PackedTypeHelper<double>::count;
+
+    for (size_t n : {size_t(1), size_t(3), size_t(7), size_t(9), size_t(1001)})
+    {
+        lineal::Row<double> row(n, lineal::fill::ones);
+        lineal::Col<double> col(n, lineal::fill::ones);
+        const size_t capacity = row.capacity();
+
+#if defined(LINEAL_PAD_STORAGE)
+        // Buffers end on a cache line and the padding past the last element is zero.
+        EXPECT_GE(capacity, n);
+        EXPECT_EQ(capacity * sizeof(double) % 64, 0u) << "n = " << n;
+
+        for (size_t i = n; i < capacity; ++i)
+        {
+            EXPECT_EQ(row.data()[i], 0.0) << "n = " << n;
+        }
+
+        // With the padding the register loop covers the whole vector and no scalar tail is left.
+        EXPECT_EQ(lineal::impl::packed_end<double>(n, n, row, col), (n + count - 1) / count);
+#else
+        EXPECT_EQ(capacity, n);
+        EXPECT_EQ(lineal::impl::packed_end<double>(n, n, row, col), n / count);
+#endif
+
+        EXPECT_EQ(lineal::sum(row), double(n));
+        EXPECT_EQ(row * col, double(n));
+    }
+}
+
+TEST(Memory, MemoryResource)
+{
+    CountingResource resource;
+
+    {
+        lineal::Row<double> a(1000, lineal::fill::ones, &resource);
+
+        EXPECT_EQ(resource.allocations, 1u);
+        EXPECT_GE(resource.outstanding, 1000 * sizeof(double));
+        EXPECT_EQ(resource.alignment, 64u);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(a.data()) % 64, 0u);
+
+        // Moves keep the buffer, and copies made on share or first write come from the same resource.
+        lineal::Row<double> b(std::move(a));
+        lineal::Row<double> c = lineal::share(b);
+        c[0] = 2.0;
+
+        EXPECT_EQ(resource.allocations, 2u);
+        EXPECT_EQ(b[0] + b[999] + c[0] + c[999], 5.0);
+
+        b = b * 2.0 + 2.0;
+
+        EXPECT_EQ(b[0], 4.0);
+        EXPECT_EQ(resource.allocations, 2u);
+    }
+
+    EXPECT_EQ(resource.deallocations, resource.allocations);
+    EXPECT_EQ(resource.outstanding, 0u);
+}
@@ -0,0 +1,103 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <stdexcept>
+
+TEST(Numa, SumAndInProd)
+{
+    for (size_t n : {size_t(0), size_t(1), size_t(1000), size_t(300000)})
+    {
+        lineal::PartitionedRow<double> row(n, lineal::fill::ones);
+        lineal::PartitionedCol<double> col(n, lineal::fill::ones);
+
+        EXPECT_DOUBLE_EQ(lineal::sum(row), double(n));
+        EXPECT_DOUBLE_EQ(row * col, double(n));
+    }
+}
+
+TEST(Numa, RejectsMismatchedVectors)
+{
+    lineal::PartitionedRow<double> row(1000, lineal::fill::ones);
+    lineal::PartitionedCol<double> col(999, lineal::fill::ones);
+
+    EXPECT_THROW(row * col, std::invalid_argument);
+}
+
+TEST(Numa, RejectsUnknownNodes)
+{
+    const size_t nodes = lineal::impl::numa_topology().nodes();
+
+    EXPECT_THROW(lineal::PartitionedRow<double>(1000, lineal::fill::ones, {nodes}), std::out_of_range);
+}
+
+TEST(Numa, PropagatesExceptions)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    lineal::set_parallel_threshold(1024);
+
+    lineal::PartitionedCol<double> col(1 << 18, lineal::fill::ones);
+    const auto &partitions = col.partitions();
+
+    EXPECT_THROW(lineal::impl::partitioned_reduce<double>(partitions, [](size_t, size_t begin, size_t) -> double
+    {
+        if (begin > 0)
+        {
+            throw std::runtime_error("chunk failed");
+        }
+
+        return 1.0;
+    }), std::runtime_error);
+
+    lineal::set_parallel_threshold(threshold);
+}
+
+TEST(Numa, NodePoolsShareTheWork)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    const size_t threads = lineal::get_num_threads();
+    lineal::set_parallel_threshold(1024);
+
+    // One thread leaves the node pools empty and the caller runs every chunk itself.
+    for (size_t t : {size_t(1), size_t(4)})
+    {
+        lineal::set_num_threads(t);
+
+        lineal::PartitionedRow<double> row(1 << 18, lineal::fill::ones);
+        lineal::PartitionedCol<double> col(1 << 18, lineal::fill::ones);
+
+        for (size_t i = 0; i < 20; ++i)
+        {
+            ASSERT_DOUBLE_EQ(row * col, double(1 << 18)) << "threads = " << t;
+        }
+    }
+
+    lineal::set_num_threads(threads);
+    lineal::set_parallel_threshold(threshold);
+}
@@ -0,0 +1,84 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+TEST(Parallel, ReconfigureWhileRunning)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    const size_t threads = lineal::get_num_threads();
+    const size_t n = 1 << 18;
+
+    lineal::set_parallel_threshold(1024);
+    lineal::set_num_threads(4);
+
+    lineal::Col<double> a(n, lineal::fill::ones);
+    std::atomic<bool> done(false);
+
+    std::thread reconfigure([&done]()
+    {
+        for (size_t i = 0; !done.load(); ++i)
+        {
+            lineal::set_num_threads(2 + i % 3);
+        }
+    });
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        ASSERT_DOUBLE_EQ(lineal::sum(a), double(n));
+    }
+
+    done.store(true);
+    reconfigure.join();
+
+    lineal::set_num_threads(threads);
+    lineal::set_parallel_threshold(threshold);
+}
+
+TEST(Parallel, NestedLoops)
+{
+    const size_t threshold = lineal::get_parallel_threshold();
+    lineal::set_parallel_threshold(64);
+
+    std::atomic<size_t> total(0);
+
+    lineal::impl::parallel_for(256, 16, [&total](size_t begin, size_t end)
+    {
+        lineal::impl::parallel_for(256, 16, [&total, begin, end](size_t b, size_t e)
+        {
+            total.fetch_add((end - begin) * (e - b));
+        });
+    });
+
+    EXPECT_EQ(total.load(), size_t(256 * 256));
+
+    lineal::set_parallel_threshold(threshold);
+}
@@ -0,0 +1,119 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <memory_resource>
+#include <thread>
+
+TEST(Scratch, RewindsAtOutermostScope)
+{
+    char *first = nullptr;
+
+    {
+        lineal::impl::ScratchScope outer;
+        std::pmr::memory_resource *resource = outer.resource();
+        first = static_cast<char *>(resource->allocate(256, 64));
+
+        char *inner_block = nullptr;
+
+        {
+            lineal::impl::ScratchScope inner;
+            inner_block = static_cast<char *>(inner.resource()->allocate(256, 64));
+            EXPECT_EQ(lineal::impl::scratch_arena().depth(), 2u);
+        }
+
+        // Closing a nested scope keeps everything allocated so far alive.
+        char *after = static_cast<char *>(resource->allocate(256, 64));
+        EXPECT_GE(inner_block, first + 256);
+        EXPECT_GE(after, inner_block + 256);
+        EXPECT_EQ(lineal::impl::scratch_arena().depth(), 1u);
+    }
+
+    EXPECT_EQ(lineal::impl::scratch_arena().depth(), 0u);
+
+    lineal::impl::ScratchScope scope;
+    EXPECT_EQ(scope.resource()->allocate(256, 64), first);
+}
+
+TEST(Scratch, MergesBlocksAfterOverflow)
+{
+    const size_t chunk = LINEAL_SCRATCH_BLOCK_BYTES / 2 + 64;
+
+    // A new thread starts with an empty arena. Each chunk fills more than half a block, so three of them need three.
+    std::thread worker([chunk]()
+    {
+        for (size_t round = 0; round < 3; ++round)
+        {
+            lineal::reset_counters();
+
+            {
+                lineal::impl::ScratchScope scope;
+
+                for (size_t i = 0; i < 3; ++i)
+                {
+                    scope.resource()->allocate(chunk, 64);
+                }
+
+                EXPECT_EQ(lineal::impl::scratch_arena().blocks(), round == 0 ? 3u : 1u) << "round " << round;
+            }
+
+            // The blocks are replaced by one that fits the whole evaluation, so later rounds allocate nothing.
+            EXPECT_EQ(lineal::impl::scratch_arena().blocks(), 1u);
+            EXPECT_EQ(lineal::counters()[lineal::Counter::allocations], round == 0 ? 4u : 0u) << "round " << round;
+        }
+    });
+
+    worker.join();
+}
+
+TEST(Scratch, SteadyLoopStopsAllocating)
+{
+    const size_t n = 10000;
+
+    lineal::Row<double> row(n, lineal::fill::ones);
+    lineal::Col<double> col(n, lineal::fill::ones);
+
+    // A plain scaled row has its scalar pulled out of the product; the affine one needs a temporary.
+    for (size_t i = 0; i < 3; ++i)
+    {
+        EXPECT_EQ((row * 2.0 + 1.0) * col, 3.0 * n);
+    }
+
+    lineal::reset_counters();
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ((row * 2.0 + 1.0) * col, 3.0 * n);
+    }
+
+    // Every product still takes its temporary from the arena, without going to the system.
+    EXPECT_EQ(lineal::counters()[lineal::Counter::temporaries], 100u);
+    EXPECT_EQ(lineal::counters()[lineal::Counter::resource_allocations], 100u);
+    EXPECT_EQ(lineal::counters()[lineal::Counter::allocations], 0u);
+}
@@ -0,0 +1,110 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+using Histogram = lineal::impl::LatencyHistogram;
+
+TEST(Tracing, HistogramBuckets)
+{
+    std::vector<uint64_t> latencies;
+
+    for (uint64_t ns = 0; ns < 4096; ++ns)
+    {
+        latencies.push_back(ns);
+    }
+
+    // Spread over every magnitude up to 2^43 ns, below the last bucket.
+    std::mt19937_64 engine(42);
+
+    for (size_t i = 0; i < 100000; ++i)
+    {
+        latencies.push_back(engine() >> (21 + engine() % 43));
+    }
+
+    for (uint64_t ns : latencies)
+    {
+        const size_t bucket = Histogram::bucket_of(ns);
+
+        ASSERT_LT(bucket, Histogram::bucket_count - 1) << "ns = " << ns;
+
+        // Every latency lies in its bucket, and a bucket is at most 1/sub_count of its latencies wide.
+        ASSERT_LE(ns, Histogram::value_of(bucket)) << "ns = " << ns;
+        ASSERT_TRUE(bucket == 0 || Histogram::value_of(bucket - 1) < ns) << "ns = " << ns;
+        ASSERT_LE(Histogram::value_of(bucket) - ns, ns / Histogram::sub_count) << "ns = " << ns;
+    }
+
+    // Latencies below sub_count have exact buckets.
+    for (uint64_t ns = 0; ns < Histogram::sub_count; ++ns)
+    {
+        EXPECT_EQ(Histogram::value_of(Histogram::bucket_of(ns)), ns);
+    }
+}
+
+TEST(Tracing, HistogramRange)
+{
+    // The buckets reach past an hour; anything longer lands in the last one.
+    const uint64_t hour = uint64_t(3600) * 1000000000;
+
+    EXPECT_GT(Histogram::value_of(Histogram::bucket_count - 1), hour);
+    EXPECT_LT(Histogram::bucket_of(hour), Histogram::bucket_count - 1);
+    EXPECT_EQ(Histogram::bucket_of(std::numeric_limits<uint64_t>::max()), Histogram::bucket_count - 1);
+
+    for (size_t bucket = 1; bucket < Histogram::bucket_count; ++bucket)
+    {
+        ASSERT_LT(Histogram::value_of(bucket - 1), Histogram::value_of(bucket)) << "bucket " << bucket;
+        ASSERT_EQ(Histogram::bucket_of(Histogram::value_of(bucket)), bucket) << "bucket " << bucket;
+    }
+}
+
+TEST(Tracing, Percentiles)
+{
+    Histogram histogram;
+
+    for (uint64_t ns = 1; ns <= 1000; ++ns)
+    {
+        histogram.record(ns * 1000);
+    }
+
+    lineal::impl::TraceTotals totals;
+    histogram.merge_into(totals.buckets, totals.count, totals.max);
+
+    EXPECT_EQ(totals.count, 1000u);
+    EXPECT_EQ(totals.max, 1000000u);
+
+    // Percentiles report the upper bound of their bucket, capped by the maximum.
+    EXPECT_GE(lineal::impl::percentile(totals, 0.5), 500000u);
+    EXPECT_LE(lineal::impl::percentile(totals, 0.5), 500000u + 500000u / Histogram::sub_count);
+    EXPECT_GE(lineal::impl::percentile(totals, 0.99), 990000u);
+    EXPECT_EQ(lineal::impl::percentile(totals, 1.0), 1000000u);
+}
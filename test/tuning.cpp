@@ -0,0 +1,124 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    void expect_config_eq(const lineal::KernelConfig &actual, const lineal::KernelConfig &expected)
+    {
+        EXPECT_EQ(actual.accumulators, expected.accumulators);
+        EXPECT_EQ(actual.unroll, expected.unroll);
+        EXPECT_EQ(actual.prefetch_lines, expected.prefetch_lines);
+        EXPECT_EQ(actual.blas_crossover, expected.blas_crossover);
+        EXPECT_EQ(actual.blas_crossover_float, expected.blas_crossover_float);
+    }
+
+    std::string write_file(const std::string &name, const std::string &contents)
+    {
+        const std::string path = ::testing::TempDir() + name;
+        std::ofstream(path) << contents;
+        return path;
+    }
+}
+
+TEST(Tuning, RoundTrip)
+{
+    const lineal::KernelConfig initial = lineal::kernel_config();
+    const std::string path = write_file("lineal_tuning_roundtrip", "other-cpu-simd128 1 2 0 100 200\n");
+
+    lineal::KernelConfig config;
+    config.accumulators = 2;
+    config.unroll = 4;
+    config.prefetch_lines = 3;
+    config.blas_crossover = 5000;
+    config.blas_crossover_float = 7000;
+
+    ASSERT_TRUE(lineal::save_tuning(path, config));
+
+    // Saving again replaces this CPU's entry and keeps the other CPU's.
+    config.unroll = 8;
+    ASSERT_TRUE(lineal::save_tuning(path, config));
+
+    lineal::KernelConfig read;
+    ASSERT_TRUE(lineal::impl::read_tuning(path, lineal::cpu_signature(), read));
+    expect_config_eq(read, config);
+
+    ASSERT_TRUE(lineal::impl::read_tuning(path, "other-cpu-simd128", read));
+    EXPECT_EQ(read.blas_crossover_float, 200u);
+
+    std::ifstream in(path);
+    std::string line;
+    size_t lines = 0;
+
+    while (std::getline(in, line))
+    {
+        ++lines;
+    }
+
+    EXPECT_EQ(lines, 2u);
+
+    ASSERT_TRUE(lineal::load_tuning(path));
+    expect_config_eq(lineal::kernel_config(), config);
+
+    lineal::set_kernel_config(initial);
+    std::remove(path.c_str());
+}
+
+TEST(Tuning, FallsBackToTheCurrentConfig)
+{
+    const lineal::KernelConfig initial = lineal::kernel_config();
+    const std::string signature = lineal::cpu_signature();
+
+    const std::string foreign = write_file("lineal_tuning_foreign", "other-cpu-simd128 2 4 3 5000 7000\n");
+    const std::string corrupt = write_file("lineal_tuning_corrupt", signature + " 2 four 3\n\x01\x02garbage\n" + signature + "\n");
+    const std::string missing = ::testing::TempDir() + "lineal_tuning_missing";
+    std::remove(missing.c_str());
+
+    for (const std::string &path : {foreign, corrupt, missing})
+    {
+        EXPECT_FALSE(lineal::load_tuning(path)) << path;
+        expect_config_eq(lineal::kernel_config(), initial);
+    }
+
+    // Entries from before the float crossover was tuned separately keep its default.
+    const std::string old = write_file("lineal_tuning_old", signature + " 2 4 3 5000\n");
+    lineal::KernelConfig read;
+
+    ASSERT_TRUE(lineal::impl::read_tuning(old, signature, read));
+    EXPECT_EQ(read.blas_crossover, 5000u);
+    EXPECT_EQ(read.blas_crossover_float, size_t(LINEAL_BLAS_CROSSOVER));
+
+    for (const std::string &path : {foreign, corrupt, old})
+    {
+        std::remove(path.c_str());
+    }
+}
@@ -0,0 +1,326 @@
+/**
+ * @cond ___LICENSE___
+ *
+ * Copyright (c) 2016-2019 Zefiros Software.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *
+ * @endcond
+ */
+#include "lineal/lineal.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+    // Sizes around the register width, the unrolled block and the parallel threshold.
+    const std::vector<size_t> sizes = {0, 1, 3, 4, 7, 8, 15, 33, 64, 127, 1000, 4097, 100003};
+
+    template<typename tVec>
+    void iota(tVec &v, double scale = 0.5)
+    {
+        for (size_t i = 0; i < v.size(); ++i)
+        {
+            v[i] = static_cast<typename tVec::value_type>(double(i % 17) * scale - 3.0);
+        }
+    }
+}
+
+TEST(Vec, Fill)
+{
+    lineal::Row<double> ones(100, lineal::fill::ones);
+    lineal::Col<double> zeros(100, lineal::fill::zeros);
+
+    for (size_t i = 0; i < 100; ++i)
+    {
+        EXPECT_EQ(ones[i], 1.0);
+        EXPECT_EQ(zeros[i], 0.0);
+    }
+}
+
+TEST(Vec, InProd)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        lineal::Col<double> col(n);
+        iota(row);
+        iota(col, 0.25);
+
+        double expected = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            expected += row[i] * col[i];
+        }
+
+        EXPECT_NEAR(row * col, expected, 1e-9 * (1 + n)) << "n = " << n;
+    }
+}
+
+TEST(Vec, InProdFloat)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<float> row(n);
+        lineal::Col<float> col(n, lineal::fill::ones);
+        iota(row);
+
+        float expected = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            expected += row[i];
+        }
+
+        EXPECT_NEAR(row * col, expected, 1e-3f * (1 + n)) << "n = " << n;
+    }
+}
+
+TEST(Vec, InProdWithPolicy)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        lineal::Col<double> col(n);
+        iota(row);
+        iota(col, 0.25);
+
+        const double expected = row * col;
+
+        EXPECT_NEAR(lineal::inprod(row, col, lineal::MemoryPolicy::streaming()), expected, 1e-9 * (1 + expected)) << "n = " << n;
+        EXPECT_NEAR(lineal::inprod(row, col, lineal::MemoryPolicy::cached()), expected, 1e-9 * (1 + expected)) << "n = " << n;
+    }
+
+    lineal::reset_counters();
+
+    lineal::Row<double> row(1 << 16, lineal::fill::ones);
+    lineal::Col<double> col(1 << 16, lineal::fill::ones);
+
+    EXPECT_EQ(lineal::inprod(row, col, lineal::MemoryPolicy::streaming()), double(1 << 16));
+    EXPECT_EQ(lineal::counters()[lineal::Counter::blas_calls], 0u);
+}
+
+TEST(Vec, InProdExpression)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        lineal::Col<double> col(n);
+        iota(row);
+        iota(col, 0.25);
+
+        double expected = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            expected += (row[i] * 2.0 + 1.0) * (col[i] / 4.0);
+        }
+
+        EXPECT_NEAR((row * 2.0 + 1.0) * (col / 4.0), expected, 1e-9 * (1 + n)) << "n = " << n;
+    }
+}
+
+TEST(Vec, InProdMixedPrecision)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        lineal::Col<float> col(n);
+        lineal::Row<float> row_f(n);
+        lineal::Col<double> col_d(n);
+        iota(row);
+        iota(col, 0.25);
+        iota(row_f, 0.25);
+        iota(col_d);
+
+        double expected = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            expected += row[i] * (col[i] * 2.0f);
+        }
+
+        EXPECT_NEAR(row * (col * 2.0f), expected, 1e-9 * (1 + n)) << "n = " << n;
+        EXPECT_NEAR((row_f * 2.0f) * col_d, expected, 1e-9 * (1 + n)) << "n = " << n;
+    }
+
+    lineal::FixedRow<double, 8> row;
+    lineal::FixedCol<float, 8> col;
+    iota(row);
+    iota(col, 0.25);
+
+    double expected = 0;
+
+    for (size_t i = 0; i < 8; ++i)
+    {
+        expected += row[i] * (col[i] * 2.0f);
+    }
+
+    EXPECT_NEAR(row * (col * 2.0f), expected, 1e-9);
+}
+
+TEST(Vec, Sum)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        iota(row);
+
+        double expected = 0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            expected += row[i];
+        }
+
+        EXPECT_NEAR(lineal::sum(row), expected, 1e-9 * (1 + n)) << "n = " << n;
+        EXPECT_NEAR(lineal::sum(3.0 - row), 3.0 * n - expected, 1e-9 * (1 + n)) << "n = " << n;
+    }
+}
+
+TEST(Vec, AssignExpression)
+{
+    for (size_t n : sizes)
+    {
+        lineal::Row<double> row(n);
+        lineal::Row<double> out(n);
+        iota(row);
+
+        out = (row + 1.0) * 3.0 - 2.0;
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            ASSERT_DOUBLE_EQ(out[i], (row[i] + 1.0) * 3.0 - 2.0) << "n = " << n << ", i = " << i;
+        }
+    }
+}
+
+TEST(Vec, ScalarChains)
+{
+    lineal::Row<double> row(1000);
+    lineal::Row<double> out(1000);
+    iota(row);
+
+    out = 1.0 - 2.0 / (row + 10.0);
+
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        ASSERT_DOUBLE_EQ(out[i], 1.0 - 2.0 / (row[i] + 10.0));
+    }
+}
+
+#ifndef NDEBUG
+TEST(VecDeathTest, AssignSizeMismatch)
+{
+    lineal::Row<double> row(8);
+    lineal::Row<double> out(4);
+
+    EXPECT_DEATH(out = row * 2.0, "sizes differ");
+    EXPECT_DEATH(out.assign_async(row * 2.0), "sizes differ");
+}
+#endif
+
+TEST(Vec, RationalChains)
+{
+    lineal::Row<double> row(1000);
+    lineal::Row<double> out(1000);
+    iota(row);
+
+    // Integer scalars compose in the node's floating point type.
+    out = 0.5 / (row + 1.0) + 1;
+
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        ASSERT_DOUBLE_EQ(out[i], 0.5 / (row[i] + 1.0) + 1.0);
+    }
+
+    out = 3.0 / (2.0 / (row * 4.0 + 1.0)) - 1.0;
+
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        ASSERT_DOUBLE_EQ(out[i], 3.0 / (2.0 / (row[i] * 4.0 + 1.0)) - 1.0);
+    }
+
+    using tAffine = decltype(lineal::impl::canonical(row * 2.0 + 1.0));
+    using tRational = decltype(2.0 / (row + 1.0));
+    static_assert(std::is_same_v<tAffine, lineal::operations::VecAffine<lineal::Row<double>, double>>);
+    static_assert(std::is_same_v<tRational, lineal::operations::VecRational<lineal::Row<double>, double>>);
+}
+
+TEST(Vec, IntegerChainsDoNotFold)
+{
+    lineal::Row<int32_t> row(8);
+    using tQuotient = decltype(100 / (row + 1));
+
+    static_assert(std::is_same_v<tQuotient, lineal::operations::ScalarDivVec<lineal::operations::VecPlusScalar<lineal::Row<int32_t>, int>, int>>);
+}
+
+TEST(Vec, StridedSubvec)
+{
+    lineal::Row<double> row(20);
+    iota(row, 1.0);
+
+    const lineal::Row<double> &view = row;
+    auto every_third = view.subvec(2, 20, 3);
+
+    ASSERT_EQ(every_third.size(), size_t(6));
+
+    for (size_t i = 0; i < every_third.size(); ++i)
+    {
+        EXPECT_EQ(every_third[i], row[2 + 3 * i]);
+    }
+
+    auto nested = every_third.subvec(1, 6, 2);
+    ASSERT_EQ(nested.size(), size_t(3));
+    EXPECT_EQ(nested[2], row[2 + 3 * 5]);
+
+    EXPECT_EQ(view.subvec(20, 20, 4).size(), size_t(0));
+}
+
+#ifndef NDEBUG
+TEST(VecDeathTest, SubvecPreconditions)
+{
+    lineal::Row<double> row(8);
+    const lineal::Row<double> &view = row;
+
+    EXPECT_DEATH(view.subvec(0, 8, 0), "step must be positive");
+    EXPECT_DEATH(view.subvec(5, 3, 1), "out of bounds");
+    EXPECT_DEATH(view.subvec(0, 9), "out of bounds");
+}
+#endif
+
+#ifndef NDEBUG
+TEST(VecDeathTest, ElementwiseSizeMismatch)
+{
+    lineal::Row<double> a(8);
+    lineal::Row<double> b(9);
+
+    EXPECT_DEATH(lineal::max(a, b), "operands differ in size");
+    EXPECT_DEATH(a < b, "operands differ in size");
+    EXPECT_DEATH((a < 1.0) & (b < 1.0), "masks differ in size");
+    EXPECT_DEATH(lineal::where(a < 1.0, b, 0.0), "mask differ in size");
+    EXPECT_DEATH(lineal::where(a < 1.0, a, b), "mask differ in size");
+}
+#endif
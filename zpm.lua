@@ -37,8 +37,48 @@ workspace "LinealLib"
 		}
 
 	project "lineal-test"
+		defines "LINEAL_ENABLE_COUNTERS"
+
+		zpm.uses {
+			"Zefiros-Software/MKL",
+			"Zefiros-Software/simdpp",
+			"Zefiros-Software/Armadillo",
+			"Zefiros-Software/GoogleTest"
+		}
+
+	project "lineal-bench"
+		kind "ConsoleApp"
+
+		files "bench/**.cpp"
+		includedirs {
+			"lineal/include/",
+			"bench/"
+		}
+
+		zpm.uses {
+			"Zefiros-Software/MKL",
+			"Zefiros-Software/simdpp",
+			"Zefiros-Software/Armadillo",
+			"Zefiros-Software/GoogleBenchmark"
+		}
+
+	project "lineal-regress"
+		kind "ConsoleApp"
+
+		files {
+			"bench/**.cpp",
+			"regress/**.cpp"
+		}
+		removefiles "bench/main.cpp"
+		includedirs {
+			"lineal/include/",
+			"bench/",
+			"regress/"
+		}
+
 		zpm.uses {
 			"Zefiros-Software/MKL",
 			"Zefiros-Software/simdpp",
-			"Zefiros-Software/Armadillo"
+			"Zefiros-Software/Armadillo",
+			"Zefiros-Software/GoogleBenchmark"
 		}